@@ -33,6 +33,7 @@
 #include "../Mod/Armor.h"
 #include "../Mod/Mod.h"
 #include "../Mod/RuleItem.h"
+#include "../Engine/Profiler.h"
 #include "../fmath.h"
 
 namespace OpenXcom
@@ -205,6 +206,7 @@ void AIModule::dont_think(BattleAction *action)
  */
 void AIModule::think(BattleAction *action)
 {
+	ProfilerScope scope("ai");
 	action->type = BA_RETHINK;
 	action->actor = _unit;
 	action->weapon = _unit->getMainHandWeapon(false);
@@ -221,6 +223,7 @@ void AIModule::think(BattleAction *action)
 	_rifle = false;
 	_blaster = false;
 	_reachable = _save->getPathfinding()->findReachable(_unit, BattleActionCost());
+	std::sort(_reachable.begin(), _reachable.end()); // only checked for membership, by tile index
 	_wasHitBy.clear();
 	_foundBaseModuleToDestroy = false;
 
@@ -1007,7 +1010,7 @@ void AIModule::setupEscape()
 		else
 		{
 			spotters = getSpottingUnits(_escapeAction.target);
-			if (std::find(_reachable.begin(), _reachable.end(), _save->getTileIndex(_escapeAction.target))  == _reachable.end())
+			if (!std::binary_search(_reachable.begin(), _reachable.end(), _save->getTileIndex(_escapeAction.target)))
 				continue; // just ignore unreachable tiles
 
 			if (_spottingEnemies || spotters)
@@ -1316,7 +1319,7 @@ bool AIModule::selectPointNearTarget(BattleUnit *target, int maxTUs)
 				if (x || y) // skip the unit itself
 				{
 					Position checkPath = target->getPosition() + Position (x, y, z);
-					if (_save->getTile(checkPath) == 0 || std::find(_reachable.begin(), _reachable.end(), _save->getTileIndex(checkPath))  == _reachable.end())
+					if (_save->getTile(checkPath) == 0 || !std::binary_search(_reachable.begin(), _reachable.end(), _save->getTileIndex(checkPath)))
 						continue;
 					int dir = _save->getTileEngine()->getDirectionTo(checkPath, target->getPosition());
 					bool valid = _save->getTileEngine()->validMeleeRange(checkPath, dir, _unit, target, 0);
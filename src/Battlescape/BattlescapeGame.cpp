@@ -52,6 +52,7 @@
 #include "../Mod/Armor.h"
 #include "../Engine/Options.h"
 #include "../Engine/RNG.h"
+#include "../Engine/ThreadPool.h"
 #include "InfoboxState.h"
 #include "InfoboxOKState.h"
 #include "UnitFallBState.h"
@@ -296,6 +297,40 @@ void BattlescapeGame::init()
 }
 
 
+/**
+ * Calculates reachable tiles of this unit and the next AI units on worker threads,
+ * before this unit's think needs them. Units that stay in place do not change
+ * the map, so the next ones can use the results without waiting.
+ * This is only a prefetch: think itself still runs on the main thread one unit at a time,
+ * and with a single thread nothing is calculated ahead.
+ * @param unit Pointer to the unit that is going to think now.
+ */
+void BattlescapeGame::prefetchAIReachable(BattleUnit *unit)
+{
+	const int threads = ThreadPool::getDefault().getThreadCount();
+	if (threads <= 1)
+	{
+		return;
+	}
+
+	std::vector<const BattleUnit*> units;
+	units.push_back(unit);
+	auto* allUnits = _save->getUnits();
+	auto curr = std::find(allUnits->begin(), allUnits->end(), unit);
+	if (curr != allUnits->end())
+	{
+		for (auto it = curr + 1; it != allUnits->end() && (int)units.size() < threads; ++it)
+		{
+			BattleUnit *bu = *it;
+			if (bu->getFaction() == unit->getFaction() && !bu->isOut() && bu->reselectAllowed() && bu->getTimeUnits() > 5)
+			{
+				units.push_back(bu);
+			}
+		}
+	}
+	_save->getPathfinding()->prefetchReachable(units, BattleActionCost());
+}
+
 /**
  * Handles the processing of the AI states of a unit.
  * @param unit Pointer to a unit.
@@ -356,6 +391,7 @@ void BattlescapeGame::handleAI(BattleUnit *unit)
 		_playedAggroSound = false;
 		unit->setHiding(false);
 		if (Options::traceAI) { Log(LOG_INFO) << "#" << unit->getId() << "--" << unit->getType(); }
+		prefetchAIReachable(unit);
 	}
 
 	BattleAction action;
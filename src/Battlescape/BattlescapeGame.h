@@ -153,6 +153,8 @@ private:
 	bool handlePanickingPlayer();
 	/// Common function for handling panicking units.
 	bool handlePanickingUnit(BattleUnit *unit);
+	/// Prefetches reachable tiles of AI units that will think next, on worker threads only.
+	void prefetchAIReachable(BattleUnit *unit);
 	/// Determines whether there are any actions pending for the given unit.
 	bool noActionsPending(BattleUnit *bu);
 	std::vector<InfoboxOKState*> _infoboxQueue;
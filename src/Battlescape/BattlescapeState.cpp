@@ -32,6 +32,7 @@
 #include "InventoryState.h"
 #include "AlienInventoryState.h"
 #include "Pathfinding.h"
+#include "UnitSprite.h"
 #include "BattlescapeGame.h"
 #include "WarningMessage.h"
 #include "InfoboxState.h"
@@ -2993,6 +2994,16 @@ inline void BattlescapeState::handle(Action *action)
 							}
 						}
 					}
+					// "ctrl-shift-t" - pathfinding benchmark
+					else if (_save->getDebugMode() && key == SDLK_t && ctrlPressed && shiftPressed)
+					{
+						benchmarkPathfinding();
+					}
+					// "ctrl-shift-c" - log reused sprite script results
+					else if (_save->getDebugMode() && key == SDLK_c && ctrlPressed && shiftPressed)
+					{
+						UnitSprite::logScriptReuse();
+					}
 					// f11 - voxel map dump
 					else if (key == SDLK_F11)
 					{
@@ -3157,6 +3168,77 @@ void BattlescapeState::saveAIMap()
 	Log(LOG_INFO) << "saveAIMap() completed in " << SDL_GetTicks() - start << "ms.";
 }
 
+/**
+ * Measures how fast pathfinding expands nodes for the selected unit,
+ * without the move cost cache, with an empty cache and with a filled cache.
+ * Then times path searches from every unit to every other unit on the map.
+ */
+void BattlescapeState::benchmarkPathfinding()
+{
+	BattleUnit *unit = _save->getSelectedUnit();
+	if (!unit) return;
+
+	Pathfinding *pf = _save->getPathfinding();
+	pf->removePreview();
+	const bool cacheOption = Options::oxcePathfindingCostCache;
+	const int runs = 20;
+
+	auto run = [&](const char *name, bool cache, int count)
+	{
+		Options::oxcePathfindingCostCache = cache;
+		Uint32 start = SDL_GetTicks();
+		const Uint64 expandedStart = pf->getExpandedNodes();
+		size_t tiles = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			pf->invalidateReachable();
+			tiles += pf->findReachable(unit, BattleActionCost()).size();
+		}
+		Uint32 time = std::max(SDL_GetTicks() - start, 1u);
+		const Uint64 nodes = pf->getExpandedNodes() - expandedStart;
+		Log(LOG_INFO) << "Pathfinding benchmark " << name << ": " << nodes << " nodes expanded (" << tiles << " reachable tiles) in " << time << "ms, " << nodes / time << " nodes/ms.";
+		return nodes / time;
+	};
+
+	pf->resetTerrainSteps();
+	Uint64 before = run("without cache", false, runs);
+	run("filling cache", true, 1);
+	Uint64 after = run("with cache", true, runs);
+
+	// path queries between all units currently on the map, like the ones AI and players make
+	std::vector<std::pair<BattleUnit*, Position>> queries;
+	for (auto* from : *_save->getUnits())
+	{
+		if (from->isOut() || from->getTile() == nullptr) continue;
+		for (auto* to : *_save->getUnits())
+		{
+			if (to == from || to->isOut() || to->getTile() == nullptr) continue;
+			queries.push_back(std::make_pair(from, to->getPosition()));
+		}
+	}
+	Uint32 start = SDL_GetTicks();
+	const Uint64 expandedStart = pf->getExpandedNodes();
+	size_t found = 0;
+	for (auto& q : queries)
+	{
+		pf->calculate(q.first, q.second, BAM_NORMAL);
+		if (pf->getStartDirection() != -1)
+		{
+			++found;
+		}
+		pf->abortPath();
+	}
+	Uint32 time = std::max(SDL_GetTicks() - start, 1u);
+	Log(LOG_INFO) << "Pathfinding benchmark paths: " << queries.size() << " queries (" << found << " found), " << pf->getExpandedNodes() - expandedStart << " nodes expanded in " << time << "ms.";
+	Options::oxcePathfindingCostCache = cacheOption;
+	// path queries set other units for pathfinding
+	pf->setUnit(unit);
+
+	std::ostringstream ss;
+	ss << "Pathfinding " << before << " -> " << after << " nodes/ms, " << queries.size() << " paths in " << time << "ms";
+	debug(ss.str());
+}
+
 /**
  * Saves a first-person voxel view of the battlescape.
  */
@@ -3303,6 +3385,7 @@ void BattlescapeState::saveVoxelMap()
 
 	Tile *tile;
 
+	_save->getTileEngine()->voxelCheckFlush();
 	for (int z = 0; z < _save->getMapSizeZ()*12; ++z)
 	{
 		image.clear();
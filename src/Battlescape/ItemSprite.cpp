@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "ItemSprite.h"
+#include "../Engine/Script.h"
 #include "../Mod/Mod.h"
 #include "../Savegame/BattleUnit.h"
 #include "../Savegame/BattleItem.h"
@@ -25,6 +26,9 @@
 namespace OpenXcom
 {
 
+/// Counters of `recolorItemSprite` results reused within one blit.
+ScriptReuseCounter ItemSprite::RecolorItemReuse;
+
 /**
  * Sets up a ItemSprite with the specified size and position.
  * @param width Width in pixels.
@@ -60,7 +64,7 @@ void ItemSprite::draw(const BattleItem* item, int x, int y, int shade)
 	{
 		ScriptWorkerBlit work;
 		BattleItem::ScriptFill(&work, item, _save, BODYPART_ITEM_FLOOR, _animationFrame, shade);
-		work.executeBlit(sprite, _dest, x, y, shade);
+		work.executeBlit(sprite, _dest, x, y, shade, &RecolorItemReuse);
 	}
 }
 
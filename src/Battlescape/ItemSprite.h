@@ -27,6 +27,7 @@ class BattleItem;
 class SavedBattleGame;
 class SurfaceSet;
 class Mod;
+struct ScriptReuseCounter;
 
 /**
  * A class that renders a specific unit, given its render rules
@@ -42,6 +43,9 @@ private:
 
 
 public:
+	/// Counters of `recolorItemSprite` results reused within one blit.
+	static ScriptReuseCounter RecolorItemReuse;
+
 	/// Creates a new ItemSprite at the specified position and size.
 	ItemSprite(Surface* dest, const Mod* mod, const SavedBattleGame *_save, int frame);
 	/// Cleans up the ItemSprite.
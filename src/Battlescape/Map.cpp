@@ -431,6 +431,29 @@ int Map::getWallShade(TilePart part, Tile* tileFrot)
 	return shade;
 }
 
+/**
+ * Draw part of tile terrain, using sprite with shade already applied if its terrain has one.
+ * @param surface Surface to draw on.
+ * @param tile Tile to draw.
+ * @param part Part of tile.
+ * @param tileScreenPosition Screen position of tile.
+ * @param shade Shade of part.
+ * @param half Draw only right half.
+ */
+void Map::drawTerrainPart(Surface *surface, Tile *tile, TilePart part, Position tileScreenPosition, int shade, bool half)
+{
+	// night vision recolor everything, it can't use prepared shades
+	auto shaded = _nvColor ? SurfaceRaw<const Uint8>{} : tile->getShadedSprite(part, shade);
+	if (shaded)
+	{
+		Surface::blitMasked(surface, shaded, tileScreenPosition.x, tileScreenPosition.y - tile->getYOffset(part), half);
+	}
+	else
+	{
+		Surface::blitRaw(surface, tile->getSprite(part), tileScreenPosition.x, tileScreenPosition.y - tile->getYOffset(part), shade, half, _nvColor);
+	}
+}
+
 /**
  * Check two positions if have same XY cords
  */
@@ -883,6 +906,8 @@ void Map::drawTerrain(Surface *surface)
 		movingUnitPosition = movingUnit->getPosition();
 	}
 
+	resetShadeCache();
+
 	surface->lock();
 	const Position cameraPos = _camera->getMapOffset();
 	for (int itZ = beginZ; itZ <= endZ; itZ++)
@@ -928,9 +953,9 @@ void Map::drawTerrain(Surface *surface)
 					if (tmpSurface)
 					{
 						if (tile->getObstacle(O_FLOOR))
-							Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_FLOOR), obstacleShade, false, _nvColor);
+							drawTerrainPart(surface, tile, O_FLOOR, screenPosition, obstacleShade, false);
 						else
-							Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_FLOOR), tileShade, false, _nvColor);
+							drawTerrainPart(surface, tile, O_FLOOR, screenPosition, tileShade, false);
 					}
 
 					auto* unit = tile->getUnit();
@@ -989,9 +1014,9 @@ void Map::drawTerrain(Surface *surface)
 						{
 							int wallShade = getWallShade(O_WESTWALL, tile);
 							if (tile->getObstacle(O_WESTWALL))
-								Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_WESTWALL), obstacleShade, false, _nvColor);
+								drawTerrainPart(surface, tile, O_WESTWALL, screenPosition, obstacleShade, false);
 							else
-								Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_WESTWALL), wallShade, false, _nvColor);
+								drawTerrainPart(surface, tile, O_WESTWALL, screenPosition, wallShade, false);
 						}
 						// Draw north wall
 						tmpSurface = tile->getSprite(O_NORTHWALL);
@@ -999,9 +1024,9 @@ void Map::drawTerrain(Surface *surface)
 						{
 							int wallShade = getWallShade(O_NORTHWALL, tile);
 							if (tile->getObstacle(O_NORTHWALL))
-								Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_NORTHWALL), obstacleShade, bool(tile->getSprite(O_WESTWALL)), _nvColor);
+								drawTerrainPart(surface, tile, O_NORTHWALL, screenPosition, obstacleShade, bool(tile->getSprite(O_WESTWALL)));
 							else
-								Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_NORTHWALL), wallShade, bool(tile->getSprite(O_WESTWALL)), _nvColor);
+								drawTerrainPart(surface, tile, O_NORTHWALL, screenPosition, wallShade, bool(tile->getSprite(O_WESTWALL)));
 						}
 						// Draw object
 						tmpSurface = tile->getSprite(O_OBJECT);
@@ -1010,9 +1035,9 @@ void Map::drawTerrain(Surface *surface)
 							if (tile->isBackTileObject(O_OBJECT))
 							{
 								if (tile->getObstacle(O_OBJECT))
-									Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_OBJECT), obstacleShade, false, _nvColor);
+									drawTerrainPart(surface, tile, O_OBJECT, screenPosition, obstacleShade, false);
 								else
-									Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_OBJECT), tileShade, false, _nvColor);
+									drawTerrainPart(surface, tile, O_OBJECT, screenPosition, tileShade, false);
 							}
 						}
 						// draw an item on top of the floor (if any)
@@ -1287,9 +1312,9 @@ void Map::drawTerrain(Surface *surface)
 							if (!tile->isBackTileObject(O_OBJECT))
 							{
 								if (tile->getObstacle(O_OBJECT))
-									Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_OBJECT), obstacleShade, false, _nvColor);
+									drawTerrainPart(surface, tile, O_OBJECT, screenPosition, obstacleShade, false);
 								else
-									Surface::blitRaw(surface, tmpSurface, screenPosition.x, screenPosition.y - tile->getYOffset(O_OBJECT), tileShade, false, _nvColor);
+									drawTerrainPart(surface, tile, O_OBJECT, screenPosition, tileShade, false);
 							}
 						}
 					}
@@ -1828,6 +1853,8 @@ void Map::drawTerrain(Surface *surface)
 	}
 
 	surface->unlock();
+
+	_shadeCache.clear();
 }
 
 /**
@@ -1921,6 +1948,49 @@ void Map::persistToggles()
  */
 
 int Map::reShade(Tile *tile)
+{
+	// during drawing every tile is asked many times, by its own parts, walls and units nearby
+	if (_shadeCache.empty())
+	{
+		resetShadeCache();
+	}
+	Sint8 &shade = _shadeCache[_save->getTileIndex(tile->getPosition())];
+	if (shade < 0)
+	{
+		shade = calculateShade(tile);
+	}
+	return shade;
+}
+
+/**
+ * Prepares the per-tile shade cache and the list of units
+ * giving local night vision, both are valid for one frame.
+ * Cleared at end of drawTerrain.
+ */
+void Map::resetShadeCache()
+{
+	_shadeCache.assign(_save->getMapSizeXYZ(), -1);
+
+	_nightVisionViewers.clear();
+	if (_debugVisionMode == 0 && _nvColor != 0)
+	{
+		for (const auto* bu : *_save->getUnits())
+		{
+			if (bu->getFaction() == FACTION_PLAYER && !bu->isOut())
+			{
+				_nightVisionViewers.push_back(std::make_pair(bu->getPosition(), bu->getMaxViewDistanceAtDarkSquared()));
+			}
+		}
+	}
+}
+
+/**
+ * Calculates shade of tile, taking fading and night vision into account.
+ * Uses the night vision units gathered by resetShadeCache().
+ * @param tile Tile to shade.
+ * @return Shade to draw tile with.
+ */
+int Map::calculateShade(Tile *tile) const
 {
 	// when modders just don't know where to stop...
 	if (_debugVisionMode > 0)
@@ -1947,14 +2017,11 @@ int Map::reShade(Tile *tile)
 	}
 
 	// hybrid night vision (local)
-	for (const auto* bu : *_save->getUnits())
+	for (const auto& viewer : _nightVisionViewers)
 	{
-		if (bu->getFaction() == FACTION_PLAYER && !bu->isOut())
+		if (Position::distance2dSq(tile->getPosition(), viewer.first) <= viewer.second)
 		{
-			if (Position::distance2dSq(tile->getPosition(), bu->getPosition()) <= bu->getMaxViewDistanceAtDarkSquared())
-			{
-				return tile->getShade() > _fadeShade ? _fadeShade : tile->getShade();
-			}
+			return tile->getShade() > _fadeShade ? _fadeShade : tile->getShade();
 		}
 	}
 
@@ -103,11 +103,18 @@ private:
 	bool _previewSettingArrows, _previewSettingTu, _previewSettingEnergy;
 	Text *_txtAccuracy;
 	SurfaceSet *_projectileSet;
+	std::vector<Sint8> _shadeCache;
+	std::vector<std::pair<Position, int>> _nightVisionViewers;
 
 	void drawUnit(UnitSprite &unitSprite, Tile *unitTile, Tile *currTile, Position tileScreenPosition, bool topLayer, BattleUnit* movingUnit = nullptr);
 	void drawTerrain(Surface *surface);
+	void drawTerrainPart(Surface *surface, Tile *tile, TilePart part, Position tileScreenPosition, int shade, bool half);
 	int getTerrainLevel(const Position& pos, int size) const;
 	int getWallShade(TilePart part, Tile* tileFrot);
+	/// Prepares the per-tile shade cache for drawing a frame.
+	void resetShadeCache();
+	/// Calculates shade of tile with fading and night vision.
+	int calculateShade(Tile *tile) const;
 	int _iconHeight, _iconWidth, _messageColor;
 	int _hostileBarColor, _neutralBarColor, _borderBarColor;
 	const std::vector<Uint8> *_transparencies;
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <list>
+#include <queue>
 #include <algorithm>
 #include "Pathfinding.h"
 #include "PathfindingOpenSet.h"
@@ -26,6 +27,8 @@
 #include "../Mod/Mod.h"
 #include "../Savegame/BattleUnit.h"
 #include "../Engine/Options.h"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/Profiler.h"
 #include "../fmath.h"
 #include "BattlescapeGame.h"
 
@@ -40,11 +43,26 @@ int Pathfinding::red = 3;
 int Pathfinding::yellow = 10;
 int Pathfinding::green = 4;
 
+namespace
+{
+
+/// Offsets of tiles occupied by parts of a unit.
+constexpr Position partOffsets[4] =
+{
+	{ 0, 0, 0 },
+	{ 1, 0, 0 },
+	{ 0, 1, 0 },
+	{ 1, 1, 0 },
+};
+
+}
+
 /**
  * Sets up a Pathfinding.
  * @param save pointer to SavedBattleGame object.
  */
-Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPreviewed(false), _strafeMove(false)
+Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _unit(0), _pathPreviewed(false), _strafeMove(false),
+	_chunksX((save->getMapSizeX() + CHUNK_SIZE - 1) / CHUNK_SIZE), _chunksY((save->getMapSizeY() + CHUNK_SIZE - 1) / CHUNK_SIZE)
 {
 	_size = _save->getMapSizeXYZ();
 	// Initialize one node per tile
@@ -83,6 +101,7 @@ PathfindingNode *Pathfinding::getNode(Position pos)
  */
 void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget, int maxTUCost)
 {
+	ProfilerScope scope("pathfinding");
 	_totalTUCost = {};
 	_path.clear();
 
@@ -167,6 +186,16 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleAction
 	{
 		abortPath(); // if bresenham failed, we shouldn't keep the path it was attempting, in case A* fails too.
 	}
+	// For long AI paths first try A* limited to chunks on a coarse path, it needs to check far fewer nodes.
+	if (Options::oxceHierarchicalPathfinding && bam != BAM_MISSILE && _unit->getFaction() != FACTION_PLAYER &&
+		findChunkCorridor(startPosition, endPosition, bam))
+	{
+		if (aStarPath(startPosition, endPosition, bam, missileTarget, sneak, maxTUCost, true))
+		{
+			return;
+		}
+		abortPath();
+	}
 	// Now try through A*.
 	if (!aStarPath(startPosition, endPosition, bam, missileTarget, sneak, maxTUCost))
 	{
@@ -183,9 +212,11 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleAction
  * @param missileTarget Target of the path.
  * @param sneak Is the unit sneaking?
  * @param maxTUCost Maximum time units the path can cost.
+ * @param useCorridor Only check nodes in chunks found by findChunkCorridor.
+ * Fails if a node outside of corridor would be checked before target, as full search could find different path.
  * @return True if a path exists, false otherwise.
  */
-bool Pathfinding::aStarPath(Position startPosition, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak, int maxTUCost)
+bool Pathfinding::aStarPath(Position startPosition, Position endPosition, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak, int maxTUCost, bool useCorridor)
 {
 	// reset every node, so we have to check them all
 	for (auto& pn : _nodes)
@@ -199,14 +230,22 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
 	PathfindingOpenSet openList;
 	openList.push(start);
 	bool missile = (bam == BAM_MISSILE);
+	// lowest open set cost of nodes skipped because they are outside of the corridor
+	int skippedCost = -1;
 	// if the open list is empty, we've reached the end
 	while (!openList.empty())
 	{
 		PathfindingNode *currentNode = openList.pop();
+		++_expandedNodes;
 		Position const &currentPos = currentNode->getPosition();
 		currentNode->setChecked();
 		if (currentPos == endPosition) // We found our target.
 		{
+			if (skippedCost != -1 && skippedCost < currentNode->getTUCost(missile).time * 4)
+			{
+				// full search would look outside of corridor first, it could find cheaper path there
+				return false;
+			}
 			_path.clear();
 			PathfindingNode *pf = currentNode;
 			while (pf->getPrevNode())
@@ -230,6 +269,19 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
 			if (nextNode->isChecked()) // Our algorithm means this node is already at minimum cost.
 				continue;
 			_totalTUCost = currentNode->getTUCost(missile) + r.cost + r.penalty;
+			if (useCorridor && !_chunkCorridor[(nextPos.y / CHUNK_SIZE) * _chunksX + nextPos.x / CHUNK_SIZE])
+			{
+				if (_totalTUCost.time <= maxTUCost)
+				{
+					// same cost as PathfindingOpenSet::push would use
+					const int nextCost = _totalTUCost.time * 4 + (Sint16)(4 * Position::distance(endPosition, nextPos));
+					if (skippedCost == -1 || nextCost < skippedCost)
+					{
+						skippedCost = nextCost;
+					}
+				}
+				continue;
+			}
 			// If this node is unvisited or has only been visited from inferior paths...
 			if ((!nextNode->inOpenSet() || nextNode->getTUCost(missile).time > _totalTUCost.time) && _totalTUCost.time <= maxTUCost)
 			{
@@ -243,19 +295,294 @@ bool Pathfinding::aStarPath(Position startPosition, Position endPosition, Battle
 }
 
 /**
- * Gets the TU cost to move from 1 tile to the other (ONE STEP ONLY).
- * But also updates the endPosition, because it is possible
- * the unit goes upstairs or falls down while walking.
+ * Finds all chunks that can be reached in one step from given chunk and the terrain cost of moving through it.
+ * Units are ignored, so links stay valid when units move during the turn.
+ * @param graph Chunk graph to update.
+ * @param chunk Index of chunk.
+ * @param bam Move type.
+ */
+void Pathfinding::buildChunkLinks(ChunkGraph &graph, int chunk, BattleActionMove bam)
+{
+	const int chunksXY = _chunksX * _chunksY;
+	const int startX = (chunk % _chunksX) * CHUNK_SIZE;
+	const int startY = ((chunk / _chunksX) % _chunksY) * CHUNK_SIZE;
+	const int z = chunk / chunksXY;
+	const int endX = std::min(startX + CHUNK_SIZE, _save->getMapSizeX());
+	const int endY = std::min(startY + CHUNK_SIZE, _save->getMapSizeY());
+	const int numberOfParts = _unit->getArmor()->getTotalSize();
+
+	auto& links = graph.links[chunk];
+	links.clear();
+	int totalCost = 0;
+	int steps = 0;
+	int minCost = -1;
+	for (int x = startX; x < endX; ++x)
+	{
+		for (int y = startY; y < endY; ++y)
+		{
+			Position pos = Position(x, y, z);
+			for (int direction = 0; direction < dir_max; ++direction)
+			{
+				TerrainStep step;
+				if (Options::oxcePathfindingCostCache)
+				{
+					step = getTerrainStep(pos, direction, _unit, bam, true);
+				}
+				else
+				{
+					getTUCostTerrain(pos, direction, _unit, nullptr, bam, true, step);
+				}
+				if (step.state != TerrainStep::VALID)
+					continue;
+
+				int cost = 0;
+				for (int i = 0; i < numberOfParts; ++i)
+				{
+					cost += step.partCost[i];
+				}
+				cost /= numberOfParts;
+				if (minCost == -1 || cost < minCost)
+				{
+					minCost = cost;
+				}
+
+				Position end;
+				directionToVector(direction, &end);
+				end += pos;
+				end.z += step.levelChange;
+				const int next = getChunkIndex(end);
+				if (next == chunk)
+				{
+					totalCost += cost;
+					++steps;
+					continue;
+				}
+				auto link = std::find_if(links.begin(), links.end(), [&](const ChunkLink &l) { return l.chunk == next; });
+				if (link == links.end())
+				{
+					links.push_back(ChunkLink{ next, cost });
+				}
+				else
+				{
+					link->cost = std::min(link->cost, cost);
+				}
+			}
+		}
+	}
+	graph.stepCost[chunk] = steps ? totalCost / steps : std::max(minCost, 0);
+	graph.minStepCost[chunk] = minCost;
+	graph.valid[chunk] = true;
+}
+
+/**
+ * Searches for a coarse path between chunks and marks chunk columns on it (and their neighbours) as the corridor
+ * that A* is allowed to use. Chunk links are reused by all units moving the same way until terrain changes.
+ * Path is weighted by terrain move cost of crossed chunks, not by number of chunks.
+ * @param origin The position to start from.
+ * @param target The position we want to reach.
+ * @param bam Move type.
+ * @return True if corridor was found and it is worth using.
+ */
+bool Pathfinding::findChunkCorridor(Position origin, Position target, BattleActionMove bam)
+{
+	const int chunksXY = _chunksX * _chunksY;
+	auto chunkPosition = [&](int chunk)
+	{
+		return Position(chunk % _chunksX, (chunk / _chunksX) % _chunksY, chunk / chunksXY);
+	};
+	auto chunkDistance = [&](int a, int b)
+	{
+		Position diff = chunkPosition(a) - chunkPosition(b);
+		return std::max(std::max(std::abs(diff.x), std::abs(diff.y)), std::abs(diff.z));
+	};
+
+	const int startChunk = getChunkIndex(origin);
+	const int endChunk = getChunkIndex(target);
+	if (chunkDistance(startChunk, endChunk) < 2)
+	{
+		// path is short, normal search is fast enough
+		return false;
+	}
+
+	const MovementType movementType = getMovementType(_unit, nullptr, bam);
+	const MovementType unitMovementType = _unit->getMovementType();
+	const int size = _unit->getArmor()->getSize();
+	ChunkGraph *graph = nullptr;
+	for (auto& g : _chunkGraphs)
+	{
+		if (g.movementType == movementType && g.unitMovementType == unitMovementType && g.size == size)
+		{
+			graph = &g;
+			break;
+		}
+	}
+	if (graph == nullptr)
+	{
+		const int chunks = chunksXY * _save->getMapSizeZ();
+		_chunkGraphs.push_back(ChunkGraph{ movementType, unitMovementType, size, { }, { }, { }, { } });
+		graph = &_chunkGraphs.back();
+		graph->links.resize(chunks);
+		graph->stepCost.resize(chunks, 0);
+		graph->minStepCost.resize(chunks, -1);
+		graph->valid.resize(chunks, false);
+	}
+
+	// all chunks are needed to know the cheapest step on the map, after the first search only chunks around changed terrain are rebuilt
+	int minStepCost = -1;
+	for (int chunk = 0; chunk < (int)graph->links.size(); ++chunk)
+	{
+		if (!graph->valid[chunk])
+		{
+			buildChunkLinks(*graph, chunk, bam);
+		}
+		const int chunkMin = graph->minStepCost[chunk];
+		if (chunkMin != -1 && (minStepCost == -1 || chunkMin < minStepCost))
+		{
+			minStepCost = chunkMin;
+		}
+	}
+
+	// A* on chunks, moving through a chunk costs its average step cost for each tile of its width.
+	// Each step between chunks crosses at least whole chunk of steps that cost no less than cheapest one on the map,
+	// so the estimate never exceeds real cost of the rest of the path.
+	const int estimateCost = std::max(minStepCost, 0) * CHUNK_SIZE;
+	std::vector<int> cost(graph->links.size(), -1);
+	std::vector<int> prev(graph->links.size(), -1);
+	std::priority_queue<std::pair<int, int>> openList;
+	cost[startChunk] = 0;
+	openList.push({ -chunkDistance(startChunk, endChunk) * estimateCost, startChunk });
+	while (!openList.empty() && openList.top().second != endChunk)
+	{
+		const int current = openList.top().second;
+		const int currentCost = -openList.top().first - chunkDistance(current, endChunk) * estimateCost;
+		openList.pop();
+		if (currentCost > cost[current])
+		{
+			continue;
+		}
+		for (const auto& link : graph->links[current])
+		{
+			const int next = link.chunk;
+			const int nextCost = currentCost + graph->stepCost[current] * (CHUNK_SIZE - 1) + link.cost;
+			if (cost[next] == -1 || cost[next] > nextCost)
+			{
+				cost[next] = nextCost;
+				prev[next] = current;
+				openList.push({ -(nextCost + chunkDistance(next, endChunk) * estimateCost), next });
+			}
+		}
+	}
+	if (cost[endChunk] == -1)
+	{
+		return false;
+	}
+
+	_chunkCorridor.assign(chunksXY, false);
+	for (int chunk = endChunk; chunk != -1; chunk = prev[chunk])
+	{
+		Position p = chunkPosition(chunk);
+		for (int x = std::max(p.x - 1, 0); x <= std::min(p.x + 1, _chunksX - 1); ++x)
+		{
+			for (int y = std::max(p.y - 1, 0); y <= std::min(p.y + 1, _chunksY - 1); ++y)
+			{
+				_chunkCorridor[y * _chunksX + x] = true;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Marks links of chunks around changed tile as outdated,
+ * they will be recalculated when next needed.
+ * @param pos Position of changed tile.
+ */
+void Pathfinding::invalidateChunks(Position pos)
+{
+	const int chunksXY = _chunksX * _chunksY;
+	const int cx = pos.x / CHUNK_SIZE;
+	const int cy = pos.y / CHUNK_SIZE;
+	for (auto& graph : _chunkGraphs)
+	{
+		for (int z = 0; z < _save->getMapSizeZ(); ++z)
+		{
+			for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, _chunksX - 1); ++x)
+			{
+				for (int y = std::max(cy - 1, 0); y <= std::min(cy + 1, _chunksY - 1); ++y)
+				{
+					graph.valid[z * chunksXY + y * _chunksX + x] = false;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Marks cached steps that can be affected by a changed tile as outdated.
+ * @param pos Position of changed tile.
+ */
+void Pathfinding::invalidateTerrainSteps(Position pos)
+{
+	// one step reads tiles up to 2 tiles away from its start (3 for big units) and 2 levels up or down
+	for (auto& cache : _terrainSteps)
+	{
+		for (int z = std::max(pos.z - 2, 0); z <= std::min(pos.z + 2, _save->getMapSizeZ() - 1); ++z)
+		{
+			for (int x = std::max(pos.x - 3, 0); x <= std::min(pos.x + 3, _save->getMapSizeX() - 1); ++x)
+			{
+				for (int y = std::max(pos.y - 3, 0); y <= std::min(pos.y + 3, _save->getMapSizeY() - 1); ++y)
+				{
+					const int index = _save->getTileIndex(Position(x, y, z)) * dir_max;
+					std::fill(cache.steps.begin() + index, cache.steps.begin() + index + dir_max, TerrainStep{});
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Marks all cached data that depend on changed tile as outdated.
+ * @param pos Position of changed tile.
+ */
+void Pathfinding::invalidateTerrain(Position pos)
+{
+	invalidateChunks(pos);
+	invalidateTerrainSteps(pos);
+	invalidateReachable();
+	for (auto& w : _workers)
+	{
+		w->invalidateTerrainSteps(pos);
+	}
+}
+
+/**
+ * Forgets all cached steps.
+ */
+void Pathfinding::resetTerrainSteps()
+{
+	_terrainSteps.clear();
+	for (auto& w : _workers)
+	{
+		w->resetTerrainSteps();
+	}
+}
+
+/**
+ * Calculates the part of one step that depends on terrain: if the step is possible,
+ * where it ends and the base move cost of each part of the unit.
+ * Units standing in destination columns are taken into account too, unless they are ignored.
  * @param startPosition The position to start from.
  * @param direction The direction we are facing.
- * @param endPosition The position we want to reach.
  * @param unit The unit moving.
  * @param missileTarget The target unit used for BAM_MISSILE.
  * @param bam What move type is required (one special case is BAM_MISSILE)?
- * @return TU cost or 255 if movement is impossible.
+ * @param ignoreUnits Do not treat units as obstacles.
+ * @param step Result of calculation.
  */
-PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const
+void Pathfinding::getTUCostTerrain(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam, bool ignoreUnits, TerrainStep &step) const
 {
+	step.state = TerrainStep::BLOCKED;
+
 	Position pos;
 	directionToVector(direction, &pos);
 	pos += startPosition;
@@ -273,13 +600,6 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	int maskOfPartsClimb = 0x0;
 	int maskArmor = size ? 0xF : 0x1;
 
-	Position offsets[4] =
-	{
-		{ 0, 0, 0 },
-		{ 1, 0, 0 },
-		{ 0, 1, 0 },
-		{ 1, 1, 0 },
-	};
 	const Tile* startTile[4] = { };
 	const Tile* aboveStart[4] = { };
 	const Tile* belowStart[4] = { };
@@ -290,11 +610,11 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	// init variables
 	for (int i = 0; i < numberOfParts; ++i)
 	{
-		const Tile* st = _save->getTile(startPosition + offsets[i]);
-		const Tile* dt = _save->getTile(pos + offsets[i]);
+		const Tile* st = _save->getTile(startPosition + partOffsets[i]);
+		const Tile* dt = _save->getTile(pos + partOffsets[i]);
 		if (!st || !dt)
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			return;
 		}
 		startTile[i] = st;
 		aboveStart[i] = _save->getAboveTile(st);
@@ -314,9 +634,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		{
 			// check if we can go this way
 			if (isBlockedDirection(unit, startTile[i], direction, bam, missileTarget))
-				return {{INVALID_MOVE_COST, 0}};
+				return;
 			if (startTile[i]->getTerrainLevel() - destinationTile[i]->getTerrainLevel() > 8)
-				return {{INVALID_MOVE_COST, 0}};
+				return;
 		}
 
 		// if we are on a stairs try to go up a level
@@ -332,9 +652,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		{
 			// 2 or more voxels poking into this tile = no go
 			BattleUnit* overlaping = destinationTile[i]->getOverlappingUnit(_save, TUO_IGNORE_SMALL);
-			if (overlaping && overlaping != unit)
+			if (overlaping && overlaping != unit && !ignoreUnits)
 			{
-				return {{INVALID_MOVE_COST, 0}};
+				return;
 			}
 		}
 
@@ -375,7 +695,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	{
 		if (direction != DIR_DOWN)
 		{
-			return {{INVALID_MOVE_COST, 0}}; //cannot walk on air
+			return; //cannot walk on air
 		}
 	}
 
@@ -391,9 +711,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		}
 
 		// check if the destination tile can be walked over
-		if (isBlocked(unit, destinationTile[i], O_FLOOR, bam, missileTarget) || isBlocked(unit, destinationTile[i], O_OBJECT, bam, missileTarget))
+		if (isBlocked(unit, destinationTile[i], O_FLOOR, bam, missileTarget, -1, ignoreUnits) || isBlocked(unit, destinationTile[i], O_OBJECT, bam, missileTarget, -1, ignoreUnits))
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			return;
 		}
 	}
 
@@ -404,28 +724,11 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		if ((t->isDoor(O_NORTHWALL)) ||
 			(t->isDoor(O_WESTWALL)))
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			return;
 		}
 	}
 
-	// pre-calculate fire penalty (to make it consistent for 2x2 units)
-	int firePenaltyCost = 0;
-	if (unit->getFaction() != FACTION_PLAYER &&
-		unit->avoidsFire())
-	{
-		for (int i = 0; i < numberOfParts; ++i)
-		{
-			if (destinationTile[i]->getFire() > 0)
-			{
-				firePenaltyCost = FIRE_PREVIEW_MOVE_COST; // try to find a better path, but don't exclude this path entirely.
-			}
-		}
-	}
-
-
 	// calculate cost and some final checks
-	int totalCost = 0;
-
 	for (int i = 0; i < numberOfParts; ++i)
 	{
 		int cost = 0;
@@ -435,9 +738,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		{
 			// check if we can go this way
 			if (isBlockedDirection(unit, startTile[i], direction, bam, missileTarget))
-				return {{INVALID_MOVE_COST, 0}};
+				return;
 			if (startTile[i]->getTerrainLevel() - destinationTile[i]->getTerrainLevel() > 8)
-				return {{INVALID_MOVE_COST, 0}};
+				return;
 		}
 		else if (direction >= DIR_UP && !triedStairsDown)
 		{
@@ -462,7 +765,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 
 					if (minCost >= INVALID_MOVE_COST)
 					{
-						return {{INVALID_MOVE_COST, 0}};
+						return;
 					}
 					cost = minCost;
 				}
@@ -473,7 +776,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 			}
 			else
 			{
-				return {{INVALID_MOVE_COST, 0}};
+				return;
 			}
 		}
 		if (upperLevel)
@@ -484,9 +787,9 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 			{
 				// check if we can go this way
 				if (isBlockedDirection(unit, startTile[i], direction, bam, missileTarget))
-					return {{INVALID_MOVE_COST, 0}};
+					return;
 				if (startTile[i]->getTerrainLevel() - destinationTile[i]->getTerrainLevel() > 8)
-					return {{INVALID_MOVE_COST, 0}};
+					return;
 			}
 		}
 
@@ -505,7 +808,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		// for backward compatiblity (100 + 100 + 100 > 255) or for (255 + 10 > 255)
 		if (wallcost >= INVALID_MOVE_COST)
 		{
-			return {{INVALID_MOVE_COST, 0}};
+			return;
 		}
 
 		// if we don't want to fall down and there is no floor, we can't know the TUs so it's default to 4
@@ -543,6 +846,172 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 
 		cost += wallcost;
 
+		// cap move cost to given limit, cost added later can't lower it
+		step.partCost[i] = std::min(cost, +MAX_MOVE_COST);
+	}
+
+	// because unit move up or down we adjust final position
+	if (triedStairs)
+	{
+		pos.z++;
+	}
+	else if (direction != DIR_DOWN && triedStairsDown)
+	{
+		pos.z--;
+	}
+
+	// for bigger sized units, check the path between parts in an X shape at the end position
+	if (size)
+	{
+		const Tile *originTile = _save->getTile(pos + Position(1,1,0));
+		const Tile *finalTile = _save->getTile(pos);
+		int tmpDirection = 7;
+		if (isBlockedDirection(unit, originTile, tmpDirection, bam, missileTarget))
+			return;
+		if (!triedStairsDown && abs(originTile->getTerrainLevel() - finalTile->getTerrainLevel()) > 10)
+			return;
+		originTile = _save->getTile(pos + Position(1,0,0));
+		finalTile = _save->getTile(pos + Position(0,1,0));
+		tmpDirection = 5;
+		if (isBlockedDirection(unit, originTile, tmpDirection, bam, missileTarget))
+			return;
+		if (!triedStairsDown && abs(originTile->getTerrainLevel() - finalTile->getTerrainLevel()) > 10)
+			return;
+	}
+
+	step.state = TerrainStep::VALID;
+	step.levelChange = pos.z - startPosition.z - dir_z[direction];
+	step.fallingDown = fallingDown;
+	step.climb = climb;
+	step.flying = flying;
+}
+
+/**
+ * Gets the terrain part of one step, from the cache when possible.
+ * Steps with units standing in destination columns are not cached as units can block them, unless units are ignored.
+ * @param startPosition The position to start from.
+ * @param direction The direction we are facing.
+ * @param unit The unit moving.
+ * @param bam Move type, can't be BAM_MISSILE.
+ * @param ignoreUnits Do not treat units as obstacles, result can be always cached.
+ * @return Terrain part of the step.
+ */
+Pathfinding::TerrainStep Pathfinding::getTerrainStep(Position startPosition, int direction, const BattleUnit *unit, BattleActionMove bam, bool ignoreUnits) const
+{
+	TerrainStep step;
+	const int size = unit->getArmor()->getSize();
+	const Tile *startTile = _save->getTile(startPosition);
+	if (!startTile)
+	{
+		getTUCostTerrain(startPosition, direction, unit, nullptr, bam, ignoreUnits, step);
+		return step;
+	}
+
+	const int topLevel = std::min(startPosition.z + 1, _save->getMapSizeZ() - 1);
+	for (int i = 0; !ignoreUnits && i < size * size; ++i)
+	{
+		Position column = startPosition + Position(dir_x[direction], dir_y[direction], 0) + partOffsets[i];
+		for (column.z = 0; column.z <= topLevel; ++column.z)
+		{
+			const Tile *tile = _save->getTile(column);
+			if (tile && tile->getUnit())
+			{
+				getTUCostTerrain(startPosition, direction, unit, nullptr, bam, ignoreUnits, step);
+				return step;
+			}
+		}
+	}
+
+	const MovementType movementType = getMovementType(unit, nullptr, bam);
+	const MovementType unitMovementType = unit->getMovementType();
+	TerrainStepCache *cache = nullptr;
+	for (auto& c : _terrainSteps)
+	{
+		if (c.movementType == movementType && c.unitMovementType == unitMovementType && c.size == size)
+		{
+			cache = &c;
+			break;
+		}
+	}
+	if (cache == nullptr)
+	{
+		_terrainSteps.push_back(TerrainStepCache{ movementType, unitMovementType, size, { } });
+		cache = &_terrainSteps.back();
+		cache->steps.resize(_size * dir_max);
+	}
+
+	TerrainStep &cached = cache->steps[_save->getTileIndex(startPosition) * dir_max + direction];
+	if (cached.state == TerrainStep::UNKNOWN)
+	{
+		getTUCostTerrain(startPosition, direction, unit, nullptr, bam, ignoreUnits, cached);
+	}
+	return cached;
+}
+
+/**
+ * Gets the TU cost to move from 1 tile to the other (ONE STEP ONLY).
+ * But also updates the endPosition, because it is possible
+ * the unit goes upstairs or falls down while walking.
+ * @param startPosition The position to start from.
+ * @param direction The direction we are facing.
+ * @param endPosition The position we want to reach.
+ * @param unit The unit moving.
+ * @param missileTarget The target unit used for BAM_MISSILE.
+ * @param bam What move type is required (one special case is BAM_MISSILE)?
+ * @return TU cost or 255 if movement is impossible.
+ */
+PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const
+{
+	const Armor* armor =  unit->getArmor();
+	const int size = armor->getSize() - 1;
+	const int numberOfParts = armor->getTotalSize();
+
+	TerrainStep step;
+	if (Options::oxcePathfindingCostCache && missileTarget == nullptr && bam != BAM_MISSILE)
+	{
+		step = getTerrainStep(startPosition, direction, unit, bam);
+	}
+	else
+	{
+		getTUCostTerrain(startPosition, direction, unit, missileTarget, bam, false, step);
+	}
+	if (step.state != TerrainStep::VALID)
+	{
+		return {{INVALID_MOVE_COST, 0}};
+	}
+
+	Position pos;
+	directionToVector(direction, &pos);
+	pos += startPosition;
+	pos.z += step.levelChange;
+
+	const Tile* destinationTile[4] = { };
+	for (int i = 0; i < numberOfParts; ++i)
+	{
+		destinationTile[i] = _save->getTile(pos + partOffsets[i]);
+	}
+
+	// pre-calculate fire penalty (to make it consistent for 2x2 units)
+	int firePenaltyCost = 0;
+	if (unit->getFaction() != FACTION_PLAYER &&
+		unit->avoidsFire())
+	{
+		for (int i = 0; i < numberOfParts; ++i)
+		{
+			if (destinationTile[i]->getFire() > 0)
+			{
+				firePenaltyCost = FIRE_PREVIEW_MOVE_COST; // try to find a better path, but don't exclude this path entirely.
+			}
+		}
+	}
+
+	// calculate cost and some final checks
+	int totalCost = 0;
+
+	for (int i = 0; i < numberOfParts; ++i)
+	{
+		int cost = step.partCost[i];
+
 		// TFTD thing: underwater tiles on fire or filled with smoke cost 2 TUs more for whatever reason.
 		if (_save->getDepth() > 0 && (destinationTile[i]->getFire() > 0 || destinationTile[i]->getSmoke() > 0))
 		{
@@ -581,43 +1050,17 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 		totalCost += cost;
 	}
 
-	// because unit move up or down we adjust final position
-	if (triedStairs)
-	{
-		pos.z++;
-	}
-	else if (direction != DIR_DOWN && triedStairsDown)
-	{
-		pos.z--;
-	}
-
-	// for bigger sized units, check the path between parts in an X shape at the end position
 	if (size)
 	{
 		totalCost /= numberOfParts;
-		const Tile *originTile = _save->getTile(pos + Position(1,1,0));
-		const Tile *finalTile = _save->getTile(pos);
-		int tmpDirection = 7;
-		if (isBlockedDirection(unit, originTile, tmpDirection, bam, missileTarget))
-			return {{INVALID_MOVE_COST, 0}};
-		if (!triedStairsDown && abs(originTile->getTerrainLevel() - finalTile->getTerrainLevel()) > 10)
-			return {{INVALID_MOVE_COST, 0}};
-		originTile = _save->getTile(pos + Position(1,0,0));
-		finalTile = _save->getTile(pos + Position(0,1,0));
-		tmpDirection = 5;
-		if (isBlockedDirection(unit, originTile, tmpDirection, bam, missileTarget))
-			return {{INVALID_MOVE_COST, 0}};
-		if (!triedStairsDown && abs(originTile->getTerrainLevel() - finalTile->getTerrainLevel()) > 10)
-			return {{INVALID_MOVE_COST, 0}};
 	}
 
-
 	if (bam == BAM_MISSILE)
 	{
 		return { { }, { }, pos };
 	}
 
-	if (direction == DIR_DOWN && fallingDown)
+	if (direction == DIR_DOWN && step.fallingDown)
 	{
 		return { { }, { firePenaltyCost, 0 }, pos };
 	}
@@ -627,11 +1070,11 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 
 	cost *= unit->getMoveCostBase();
 
-	if (climb)
+	if (step.climb)
 	{
 		cost *= unit->getMoveCostBaseClimb();
 	}
-	else if (flying)
+	else if (step.flying)
 	{
 		cost *= unit->getMoveCostBaseFly();
 	}
@@ -642,7 +1085,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 
 	if (direction >= Pathfinding::DIR_UP)
 	{
-		if (climb)
+		if (step.climb)
 		{
 			if (direction == Pathfinding::DIR_UP)
 			{
@@ -653,7 +1096,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 				cost *= armor->getMoveCostClimbDown();
 			}
 		}
-		else if (flying)
+		else if (step.flying)
 		{
 			if (direction == Pathfinding::DIR_UP)
 			{
@@ -672,7 +1115,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	}
 	else if (bam == BAM_NORMAL)
 	{
-		if (flying)
+		if (step.flying)
 		{
 			cost *= armor->getMoveCostFlyWalk();
 		}
@@ -683,7 +1126,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	}
 	else if (bam == BAM_RUN)
 	{
-		if (flying)
+		if (step.flying)
 		{
 			cost *= armor->getMoveCostFlyRun();
 		}
@@ -694,7 +1137,7 @@ PathfindingStep Pathfinding::getTUCost(Position startPosition, int direction, co
 	}
 	else if (bam == BAM_STRAFE)
 	{
-		if (flying)
+		if (step.flying)
 		{
 			cost *= armor->getMoveCostFlyStrafe();
 		}
@@ -785,9 +1228,11 @@ MovementType Pathfinding::getMovementType(const BattleUnit *unit, const BattleUn
  * @param tile Specified tile, can be a null pointer.
  * @param part Part of the tile.
  * @param missileTarget Target for a missile.
+ * @param bigWallExclusion Big wall type that does not block.
+ * @param ignoreUnits Do not treat units as obstacles.
  * @return True if the movement is blocked.
  */
-bool Pathfinding::isBlocked(const BattleUnit *unit, const Tile *tile, const int part, BattleActionMove bam, const BattleUnit *missileTarget, int bigWallExclusion) const
+bool Pathfinding::isBlocked(const BattleUnit *unit, const Tile *tile, const int part, BattleActionMove bam, const BattleUnit *missileTarget, int bigWallExclusion, bool ignoreUnits) const
 {
 	if (tile == 0) return true; // probably outside the map here
 
@@ -835,7 +1280,7 @@ bool Pathfinding::isBlocked(const BattleUnit *unit, const Tile *tile, const int
 		if (tile->getUnit())
 		{
 			BattleUnit *u = tile->getUnit();
-			if (u == unit || u == missileTarget || u->isOut())
+			if (u == unit || u == missileTarget || u->isOut() || ignoreUnits)
 				return false;
 			if (unit)
 			{
@@ -856,7 +1301,7 @@ bool Pathfinding::isBlocked(const BattleUnit *unit, const Tile *tile, const int
 				Tile *t = _save->getTile(pos);
 				BattleUnit *u = t->getUnit();
 
-				if (u != 0 && u != unit)
+				if (u != 0 && u != unit && !ignoreUnits)
 				{
 					// don't let large units fall on other units
 					if (unit && unit->isBigUnit())
@@ -1420,25 +1865,57 @@ bool Pathfinding::bresenhamPath(Position origin, Position target, BattleActionMo
 }
 
 /**
- * Locates all tiles reachable to @a *unit with a TU cost no more than @a tuMax.
- * Uses Dijkstra's algorithm.
- * @param unit Pointer to the unit.
- * @param tuMax The maximum cost of the path to each tile.
- * @return An array of reachable tiles, sorted in ascending order of cost. The first tile is the start location.
+ * Makes empty result of findReachable for unit and cost, used to look up or fill the cache.
+ * @param unit Unit moving.
+ * @param cost Cost of action done after moving.
+ * @return Result without any tiles.
  */
-std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const BattleActionCost &cost)
+Pathfinding::ReachableCache Pathfinding::getReachableKey(const BattleUnit *unit, const BattleActionCost &cost) const
 {
-	const Position start = unit->getPosition();
 	int tuMax = unit->getTimeUnits() - cost.Time;
 	int energyMax = unit->getEnergy() - cost.Energy;
 
 	PathfindingCost costMax = { tuMax, energyMax };
+	return ReachableCache{ unit, unit->getPosition(), costMax, unit->getUnitsSpottedThisTurn().size(), BattleUnit::getVisibilityVersion(), { } };
+}
+
+/**
+ * Finds kept result of findReachable with the same inputs.
+ * @param key Result made by getReachableKey.
+ * @return Kept result or null if there is none.
+ */
+Pathfinding::ReachableCache *Pathfinding::findReachableCache(const ReachableCache &key)
+{
+	if (_reachableCacheVersion != _reachableVersion)
+	{
+		_reachable.clear();
+		_reachableCacheVersion = _reachableVersion;
+	}
+	for (auto& r : _reachable)
+	{
+		if (r.unit == key.unit && r.position == key.position && r.costMax.time == key.costMax.time && r.costMax.energy == key.costMax.energy && r.spotted == key.spotted && r.visibility == key.visibility)
+		{
+			return &r;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * Fills all tiles reachable by a unit and the cost to reach them.
+ * Uses Dijkstra's algorithm.
+ * @param result Result made by getReachableKey.
+ */
+void Pathfinding::calculateReachable(ReachableCache &result)
+{
+	const BattleUnit *unit = result.unit;
+	const PathfindingCost costMax = result.costMax;
 
 	for (auto& pn : _nodes)
 	{
 		pn.reset();
 	}
-	PathfindingNode *startNode = getNode(start);
+	PathfindingNode *startNode = getNode(result.position);
 	startNode->connect({}, 0, 0);
 	PathfindingOpenSet unvisited;
 	unvisited.push(startNode);
@@ -1446,6 +1923,7 @@ std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const Battle
 	while (!unvisited.empty())
 	{
 		PathfindingNode *currentNode = unvisited.pop();
+		++_expandedNodes;
 		Position const &currentPos = currentNode->getPosition();
 
 		// Try all reachable neighbours.
@@ -1471,13 +1949,89 @@ std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const Battle
 		reachable.push_back(currentNode);
 	}
 	std::sort(reachable.begin(), reachable.end(), MinNodeCosts());
-	std::vector<int> tiles;
-	tiles.reserve(reachable.size());
+
+	result.tiles.reserve(reachable.size());
 	for (auto* pn : reachable)
 	{
-		tiles.push_back(_save->getTileIndex(pn->getPosition()));
+		result.tiles.push_back(_save->getTileIndex(pn->getPosition()));
 	}
-	return tiles;
+}
+
+/**
+ * Gets all tiles reachable by a unit and the cost to reach them.
+ * Result is calculated once and reused until a unit moves, the map changes or the turn ends.
+ * @param unit Unit moving.
+ * @param cost Cost of action done after moving.
+ * @return Cached reachable tiles.
+ */
+const Pathfinding::ReachableCache &Pathfinding::getReachable(const BattleUnit *unit, const BattleActionCost &cost)
+{
+	ReachableCache key = getReachableKey(unit, cost);
+	if (ReachableCache *r = findReachableCache(key))
+	{
+		return *r;
+	}
+	calculateReachable(key);
+	_reachable.push_back(std::move(key));
+	return _reachable.back();
+}
+
+/**
+ * Calculates findReachable for several units at once, spread over the worker threads.
+ * Each thread uses its own copy of the pathfinding nodes and only reads the battle state,
+ * results are added to the cache in the order of units, so later lookups do not depend on thread timing.
+ * Does nothing when there is only one thread.
+ * @param units Units to calculate.
+ * @param cost Cost of action done after moving.
+ */
+void Pathfinding::prefetchReachable(const std::vector<const BattleUnit*> &units, const BattleActionCost &cost)
+{
+	ThreadPool &pool = ThreadPool::getDefault();
+	if (pool.getThreadCount() <= 1)
+	{
+		return;
+	}
+
+	std::vector<ReachableCache> results;
+	for (auto* unit : units)
+	{
+		ReachableCache key = getReachableKey(unit, cost);
+		if (!findReachableCache(key))
+		{
+			results.push_back(std::move(key));
+		}
+	}
+	if (results.size() < 2)
+	{
+		return; // nothing to gain, leave it to getReachable
+	}
+
+	while ((int)_workers.size() < pool.getThreadCount())
+	{
+		_workers.push_back(std::make_unique<Pathfinding>(_save));
+	}
+	pool.parallelFor((int)results.size(), [&](int index, int worker)
+	{
+		_workers[worker]->calculateReachable(results[index]);
+	});
+
+	for (auto& r : results)
+	{
+		_reachable.push_back(std::move(r));
+	}
+}
+
+/**
+ * Locates all tiles reachable to @a *unit with a TU cost no more than @a tuMax.
+ * Uses Dijkstra's algorithm, see getReachable.
+ * @param unit Pointer to the unit.
+ * @param tuMax The maximum cost of the path to each tile.
+ * @return An array of reachable tiles, sorted in ascending order of cost. The first tile is the start location.
+ */
+std::vector<int> Pathfinding::findReachable(const BattleUnit *unit, const BattleActionCost &cost)
+{
+	ProfilerScope scope("reachable");
+	return getReachable(unit, cost).tiles;
 }
 
 /**
@@ -18,6 +18,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <vector>
+#include <memory>
 #include "Position.h"
 #include "PathfindingNode.h"
 #include "../Mod/MapData.h"
@@ -53,20 +54,125 @@ private:
 	bool _ctrlUsed = false;
 	bool _altUsed = false;
 	PathfindingCost _totalTUCost;
+	/// Number of nodes expanded by searches, for benchmarks.
+	Uint64 _expandedNodes = 0;
+
+	/// Size of pathfinding chunk, same grid as map blocks in SavedBattleGame::getModuleMap.
+	constexpr static int CHUNK_SIZE = 10;
+
+	/**
+	 * Step from one chunk to a neighbouring one.
+	 */
+	struct ChunkLink
+	{
+		int chunk;
+		/// Cheapest terrain cost of a step that crosses to the other chunk.
+		int cost;
+	};
+	/**
+	 * Coarse connectivity between map chunks (one map block on one level) for units moving in the same way.
+	 * Only terrain is taken into account, units are checked by the fine search.
+	 */
+	struct ChunkGraph
+	{
+		MovementType movementType;
+		MovementType unitMovementType;
+		int size;
+		/// Chunks reachable in one step from each chunk.
+		std::vector<std::vector<ChunkLink>> links;
+		/// Average terrain cost of a step inside each chunk.
+		std::vector<int> stepCost;
+		/// Cheapest terrain cost of a step starting in each chunk, -1 if there is none.
+		std::vector<int> minStepCost;
+		/// Are links of chunk up to date?
+		std::vector<bool> valid;
+	};
+	int _chunksX, _chunksY;
+	std::vector<ChunkGraph> _chunkGraphs;
+	std::vector<bool> _chunkCorridor;
+
+	/**
+	 * Part of one step that depends only on terrain, see getTUCostTerrain.
+	 */
+	struct TerrainStep
+	{
+		enum State : Uint8 { UNKNOWN, BLOCKED, VALID };
+
+		State state = UNKNOWN;
+		/// Level change from stairs at the end of step.
+		Sint8 levelChange = 0;
+		bool fallingDown = false;
+		bool climb = false;
+		bool flying = false;
+		/// Move cost for each part of the unit, capped to MAX_MOVE_COST.
+		Uint8 partCost[4] = { };
+	};
+	/**
+	 * Cached terrain steps for all tiles and directions, for units moving in the same way.
+	 */
+	struct TerrainStepCache
+	{
+		MovementType movementType;
+		MovementType unitMovementType;
+		int size;
+		std::vector<TerrainStep> steps;
+	};
+	mutable std::vector<TerrainStepCache> _terrainSteps;
+
+	/**
+	 * Result of findReachable kept for reuse until a unit moves or the map changes.
+	 */
+	struct ReachableCache
+	{
+		const BattleUnit *unit;
+		Position position;
+		PathfindingCost costMax;
+		size_t spotted;
+		Uint32 visibility;
+		/// Reachable tiles ordered by cost, as returned by findReachable.
+		std::vector<int> tiles;
+	};
+	std::vector<ReachableCache> _reachable;
+	Uint32 _reachableVersion = 0;
+	Uint32 _reachableCacheVersion = 0;
+	/// Copies used by worker threads in prefetchReachable.
+	std::vector<std::unique_ptr<Pathfinding>> _workers;
 
 	/// Gets the node at certain position.
 	PathfindingNode *getNode(Position pos);
+	/// Gets index of chunk that contains position.
+	int getChunkIndex(Position pos) const { return (pos.z * _chunksY + pos.y / CHUNK_SIZE) * _chunksX + pos.x / CHUNK_SIZE; }
+	/// Finds links from given chunk to its neighbours.
+	void buildChunkLinks(ChunkGraph &graph, int chunk, BattleActionMove bam);
+	/// Finds chunks that a path between two positions should go through.
+	bool findChunkCorridor(Position origin, Position target, BattleActionMove bam);
+	/// Marks chunks around changed tile as outdated.
+	void invalidateChunks(Position pos);
+	/// Marks cached steps around changed tile as outdated.
+	void invalidateTerrainSteps(Position pos);
+	/// Calculates the part of a step that depends on terrain.
+	void getTUCostTerrain(Position startPosition, int direction, const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam, bool ignoreUnits, TerrainStep &step) const;
+	/// Gets the part of a step that depends on terrain, using the cache.
+	TerrainStep getTerrainStep(Position startPosition, int direction, const BattleUnit *unit, BattleActionMove bam, bool ignoreUnits = false) const;
+	/// Makes empty result of findReachable for unit and cost.
+	ReachableCache getReachableKey(const BattleUnit *unit, const BattleActionCost &cost) const;
+	/// Finds kept result of findReachable with the same inputs.
+	ReachableCache *findReachableCache(const ReachableCache &key);
+	/// Fills all reachable tiles with their costs.
+	void calculateReachable(ReachableCache &result);
+	/// Gets all reachable tiles with their costs, using the cache.
+	const ReachableCache &getReachable(const BattleUnit *unit, const BattleActionCost &cost);
 
 	/// Gets movement type of unit or movement of missile.
 	MovementType getMovementType(const BattleUnit *unit, const BattleUnit *missileTarget, BattleActionMove bam) const;
 	/// Determines whether a tile blocks a certain movementType.
-	bool isBlocked(const BattleUnit *unit, const Tile *tile, const int part, BattleActionMove bam, const BattleUnit *missileTarget, int bigWallExclusion = -1) const;
+	bool isBlocked(const BattleUnit *unit, const Tile *tile, const int part, BattleActionMove bam, const BattleUnit *missileTarget, int bigWallExclusion = -1, bool ignoreUnits = false) const;
 	/// Determines whether or not movement between start tile and end tile is possible in the direction.
 	bool isBlockedDirection(const BattleUnit *unit, const Tile *startTile, const int direction, BattleActionMove bam, const BattleUnit *missileTarget) const;
 	/// Tries to find a straight line path between two positions.
 	bool bresenhamPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
 	/// Tries to find a path between two positions.
-	bool aStarPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000);
+	bool aStarPath(Position origin, Position target, BattleActionMove bam, const BattleUnit *missileTarget, bool sneak = false, int maxTUCost = 1000, bool useCorridor = false);
 	/// Determines whether a unit can fall down from this tile.
 	bool canFallDown(const Tile *destinationTile) const;
 	/// Determines whether a unit can fall down from this tile.
@@ -267,6 +373,10 @@ public:
 	void setUnit(BattleUnit *unit);
 	/// Gets all reachable tiles, based on cost.
 	std::vector<int> findReachable(const BattleUnit *unit, const BattleActionCost &cost);
+	/// Calculates reachable tiles of several units in parallel.
+	void prefetchReachable(const std::vector<const BattleUnit*> &units, const BattleActionCost &cost);
+	/// Gets number of nodes expanded by all searches so far.
+	Uint64 getExpandedNodes() const { return _expandedNodes; }
 	/// Gets _totalTUCost; finds out whether we can hike somewhere in this turn or not.
 	int getTotalTUCost() const { return _totalTUCost.time; }
 	/// Gets the path preview setting.
@@ -279,6 +389,12 @@ public:
 	const std::vector<int> &getPath() const;
 	/// Makes a copy to the path.
 	std::vector<int> copyPath() const;
+	/// Marks cached data around changed tile as outdated.
+	void invalidateTerrain(Position pos);
+	/// Forgets all cached steps.
+	void resetTerrainSteps();
+	/// Marks all cached reachable tiles as outdated.
+	void invalidateReachable() { ++_reachableVersion; }
 };
 
 }
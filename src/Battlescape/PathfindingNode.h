@@ -93,8 +93,8 @@ private:
 	Sint16 _tuGuess;
 	/// Is best path find for this tile.
 	bool _checked;
-	// Invasive field needed by PathfindingOpenSet
-	Uint8 _openentry;
+	// Invasive field needed by PathfindingOpenSet, position in its heap plus one
+	Uint32 _openentry;
 	friend class PathfindingOpenSet;
 public:
 	/// Creates a new PathfindingNode class.
@@ -28,18 +28,70 @@ namespace OpenXcom
  */
 PathfindingOpenSet::~PathfindingOpenSet()
 {
+	for (auto& e : _heap)
+	{
+		e._node->_openentry = 0;
+	}
+}
 
+/**
+ * Places entry at given position of heap and stores that position in its node.
+ * @param index Position in heap.
+ * @param entry Entry to place.
+ */
+void PathfindingOpenSet::place(size_t index, const OpenSetEntry &entry)
+{
+	_heap[index] = entry;
+	entry._node->_openentry = index + 1;
+}
+
+/**
+ * Moves entry up until its parent has lower or equal cost.
+ * @param index Starting position in heap.
+ * @param entry Entry to move.
+ */
+void PathfindingOpenSet::siftUp(size_t index, OpenSetEntry entry)
+{
+	while (index > 0)
+	{
+		size_t parent = (index - 1) / 2;
+		if (!(entry._cost < _heap[parent]._cost))
+		{
+			break;
+		}
+		place(index, _heap[parent]);
+		index = parent;
+	}
+	place(index, entry);
 }
 
 /**
- * Keeps removing all discarded entries that have come to the top of the queue.
+ * Moves entry down until both its children have higher or equal cost.
+ * @param index Starting position in heap.
+ * @param entry Entry to move.
  */
-void PathfindingOpenSet::removeDiscarded()
+void PathfindingOpenSet::siftDown(size_t index, OpenSetEntry entry)
 {
-	while (!_queue.empty() && _queue.top()._node->_openentry != _queue.top()._openentry)
+	const size_t size = _heap.size();
+	while (true)
 	{
-		_queue.pop();
+		size_t child = index * 2 + 1;
+		if (child >= size)
+		{
+			break;
+		}
+		if (child + 1 < size && _heap[child + 1]._cost < _heap[child]._cost)
+		{
+			++child;
+		}
+		if (!(_heap[child]._cost < entry._cost))
+		{
+			break;
+		}
+		place(index, _heap[child]);
+		index = child;
 	}
+	place(index, entry);
 }
 
 /**
@@ -51,30 +103,47 @@ PathfindingNode *PathfindingOpenSet::pop()
 {
 	assert(!empty());
 
-	PathfindingNode *nd = _queue.top()._node;
-	_queue.pop();
+	PathfindingNode *nd = _heap.front()._node;
+	OpenSetEntry last = _heap.back();
+	_heap.pop_back();
+	if (!_heap.empty())
+	{
+		siftDown(0, last);
+	}
 	nd->_openentry = 0;
-
-	// Discarded entries might be visible now.
-	removeDiscarded();
 	return nd;
 }
 
 /**
  * Places the node in the set.
- * If the node was already in the set, the previous entry is discarded.
+ * If the node was already in the set, its entry is updated with the new cost and moved up.
  * It is the caller's responsibility to never re-add a node with a worse cost.
  * @param node A pointer to the node to add.
  */
 void PathfindingOpenSet::push(PathfindingNode *node)
 {
-	assert(node->_openentry != 255u);
-
 	OpenSetEntry entry = {};
 	entry._node = node;
 	entry._cost = node->getTUCost(false).time * 4 + node->getTUGuess(); //HACK: this is not real cost, more rough approximation for algorithm, as bonus `getTUGuess` work more like gravity/potential than normal cost.
-	entry._openentry = ++node->_openentry; // next unique number, used to check if old recode is still valid.
-	_queue.push(entry);
+
+	if (node->_openentry != 0)
+	{
+		size_t index = node->_openentry - 1;
+		assert(index < _heap.size() && _heap[index]._node == node);
+		if (_heap[index]._cost < entry._cost)
+		{
+			siftDown(index, entry);
+		}
+		else
+		{
+			siftUp(index, entry);
+		}
+	}
+	else
+	{
+		_heap.push_back(entry);
+		siftUp(_heap.size() - 1, entry);
+	}
 }
 
 
@@ -17,7 +17,7 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
-#include <queue>
+#include <vector>
 #include <SDL_stdinc.h>
 
 namespace OpenXcom
@@ -29,29 +29,12 @@ struct OpenSetEntry
 {
 	PathfindingNode *_node;
 	Sint16 _cost;
-	Uint8 _openentry;
-};
-
-/**
- * Helper class to compare entries through pointers.
- */
-class EntryCompare
-{
-public:
-	/**
-	 * Compares entries @a *a and @a *b.
-	 * @param a Pointer to first entry.
-	 * @param b Pointer to second entry.
-	 * @return True if entry @a *b must come before @a *a.
-	 */
-	bool operator()(const OpenSetEntry& a, const OpenSetEntry& b) const
-	{
-		return b._cost < a._cost;
-	}
 };
 
 /**
  * A class that holds references to the nodes to be examined in pathfinding.
+ * Binary heap that knows where each node is, so a node that gets a better cost
+ * is moved up instead of being added again.
  */
 class PathfindingOpenSet
 {
@@ -63,13 +46,17 @@ public:
 	/// Adds a node to the set.
 	void push(PathfindingNode *node);
 	/// Is the set empty?
-	bool empty() const { return _queue.empty(); }
+	bool empty() const { return _heap.empty(); }
 
 private:
-	std::priority_queue<OpenSetEntry, std::vector<OpenSetEntry>, EntryCompare> _queue;
-
-	/// Removes reachable discarded entries.
-	void removeDiscarded();
+	std::vector<OpenSetEntry> _heap;
+
+	/// Places entry at heap position and updates node.
+	void place(size_t index, const OpenSetEntry &entry);
+	/// Moves entry toward top of heap.
+	void siftUp(size_t index, OpenSetEntry entry);
+	/// Moves entry toward bottom of heap.
+	void siftDown(size_t index, OpenSetEntry entry);
 };
 
 }
@@ -32,6 +32,7 @@
 #include "../Savegame/HitLog.h"
 #include "../Engine/RNG.h"
 #include "../Engine/GraphSubset.h"
+#include "../Engine/Collections.h"
 #include "BattlescapeState.h"
 #include "../Mod/MapDataSet.h"
 #include "../Mod/Unit.h"
@@ -40,6 +41,8 @@
 #include "../Mod/RuleSkill.h"
 #include "Pathfinding.h"
 #include "../Engine/Options.h"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/Profiler.h"
 #include "ProjectileFlyBState.h"
 #include "MeleeAttackBState.h"
 #include "../fmath.h"
@@ -50,77 +53,102 @@ namespace
 {
 
 /**
- * Calculates a line trajectory, using bresenham algorithm in 3D.
- * @param origin Origin.
- * @param target Target.
- * @param posFunc Function call for each step in primary direction of line.
- * @param driftFunc Function call for each side step of line.
+ * Calculates a line trajectory, using bresenham algorithm in 3D, one step at a time.
  */
-template<typename FuncNewPosition, typename FuncDrift>
-bool calculateLineHelper(const Position& origin, const Position& target, FuncNewPosition posFunc, FuncDrift driftFunc)
+struct LineHelperState
 {
-	int x, x0, x1, delta_x, step_x;
-	int y, y0, y1, delta_y, step_y;
-	int z, z0, z1, delta_z, step_z;
-	int swap_xy, swap_xz;
+	int x, x1, y, z;
+	int delta_x, delta_y, delta_z;
+	int step_x, step_y, step_z;
 	int drift_xy, drift_xz;
-	int cx, cy, cz;
-
-	//start and end points
-	x0 = origin.x;	 x1 = target.x;
-	y0 = origin.y;	 y1 = target.y;
-	z0 = origin.z;	 z1 = target.z;
+	bool swap_xy, swap_xz;
+	/// Was the target reached?
+	bool finished;
 
-	//'steep' xy Line, make longest delta x plane
-	swap_xy = abs(y1 - y0) > abs(x1 - x0);
-	if (swap_xy)
+	/**
+	 * Setup line.
+	 * @param origin Origin.
+	 * @param target Target.
+	 */
+	void init(const Position& origin, const Position& target)
 	{
-		std::swap(x0, y0);
-		std::swap(x1, y1);
-	}
+		//start and end points
+		int x0 = origin.x;
+		int y0 = origin.y;
+		int z0 = origin.z;
+		int y1 = target.y;
+		int z1 = target.z;
+		x1 = target.x;
 
-	//do same for xz
-	swap_xz = abs(z1 - z0) > abs(x1 - x0);
-	if (swap_xz)
-	{
-		std::swap(x0, z0);
-		std::swap(x1, z1);
-	}
+		//'steep' xy Line, make longest delta x plane
+		swap_xy = abs(y1 - y0) > abs(x1 - x0);
+		if (swap_xy)
+		{
+			std::swap(x0, y0);
+			std::swap(x1, y1);
+		}
+
+		//do same for xz
+		swap_xz = abs(z1 - z0) > abs(x1 - x0);
+		if (swap_xz)
+		{
+			std::swap(x0, z0);
+			std::swap(x1, z1);
+		}
 
-	//delta is Length in each plane
-	delta_x = abs(x1 - x0);
-	delta_y = abs(y1 - y0);
-	delta_z = abs(z1 - z0);
+		//delta is Length in each plane
+		delta_x = abs(x1 - x0);
+		delta_y = abs(y1 - y0);
+		delta_z = abs(z1 - z0);
 
-	//drift controls when to step in 'shallow' planes
-	//starting value keeps Line centred
-	drift_xy  = (delta_x / 2);
-	drift_xz  = (delta_x / 2);
+		//drift controls when to step in 'shallow' planes
+		//starting value keeps Line centred
+		drift_xy = (delta_x / 2);
+		drift_xz = (delta_x / 2);
 
-	//direction of line
-	step_x = 1;  if (x0 > x1) {  step_x = -1; }
-	step_y = 1;  if (y0 > y1) {  step_y = -1; }
-	step_z = 1;  if (z0 > z1) {  step_z = -1; }
+		//direction of line
+		step_x = x0 > x1 ? -1 : 1;
+		step_y = y0 > y1 ? -1 : 1;
+		step_z = z0 > z1 ? -1 : 1;
 
-	//starting point
-	y = y0;
-	z = z0;
+		//starting point
+		x = x0;
+		y = y0;
+		z = z0;
+		finished = false;
+	}
 
-	//step through longest delta (which we have swapped to x)
-	for (x = x0; ; x += step_x)
+	/**
+	 * Current position in normal space.
+	 */
+	Position get() const
 	{
-		//copy position
-		cx = x;	cy = y;	cz = z;
-
+		int cx = x, cy = y, cz = z;
 		//unswap (in reverse)
 		if (swap_xz) std::swap(cx, cz);
 		if (swap_xy) std::swap(cx, cy);
-		if (posFunc(Position(cx, cy, cz)))
+		return Position(cx, cy, cz);
+	}
+
+	/**
+	 * Do one step through longest delta (which we have swapped to x).
+	 * @param posFunc Function call for each step in primary direction of line.
+	 * @param driftFunc Function call for each side step of line.
+	 * @return True when one of functions returns true.
+	 */
+	template<typename FuncNewPosition, typename FuncDrift>
+	bool step(FuncNewPosition posFunc, FuncDrift driftFunc)
+	{
+		if (posFunc(get()))
 		{
 			return true;
 		}
 
-		if (x == x1) break;
+		if (x == x1)
+		{
+			finished = true;
+			return false;
+		}
 
 		//update progress in other planes
 		drift_xy = drift_xy - delta_y;
@@ -131,11 +159,7 @@ bool calculateLineHelper(const Position& origin, const Position& target, FuncNew
 		{
 			y = y + step_y;
 			drift_xy = drift_xy + delta_x;
-
-			cx = x;	cz = z; cy = y;
-			if (swap_xz) std::swap(cx, cz);
-			if (swap_xy) std::swap(cx, cy);
-			if (driftFunc(Position(cx, cy, cz)))
+			if (driftFunc(get()))
 			{
 				return true;
 			}
@@ -146,15 +170,35 @@ bool calculateLineHelper(const Position& origin, const Position& target, FuncNew
 		{
 			z = z + step_z;
 			drift_xz = drift_xz + delta_x;
-
-			cx = x;	cz = z; cy = y;
-			if (swap_xz) std::swap(cx, cz);
-			if (swap_xy) std::swap(cx, cy);
-			if (driftFunc(Position(cx, cy, cz)))
+			if (driftFunc(get()))
 			{
 				return true;
 			}
 		}
+
+		x += step_x;
+		return false;
+	}
+};
+
+/**
+ * Calculates a line trajectory, using bresenham algorithm in 3D.
+ * @param origin Origin.
+ * @param target Target.
+ * @param posFunc Function call for each step in primary direction of line.
+ * @param driftFunc Function call for each side step of line.
+ */
+template<typename FuncNewPosition, typename FuncDrift>
+bool calculateLineHelper(const Position& origin, const Position& target, FuncNewPosition posFunc, FuncDrift driftFunc)
+{
+	LineHelperState line;
+	line.init(origin, target);
+	while (!line.finished)
+	{
+		if (line.step(posFunc, driftFunc))
+		{
+			return true;
+		}
 	}
 	return false;
 }
@@ -895,6 +939,7 @@ constexpr Position TileEngine::voxelTileCenter;
  */
 TileEngine::TileEngine(SavedBattleGame *save, Mod *mod) :
 	_save(save), _voxelData(mod->getVoxelData()), _inventorySlotGround(mod->getInventoryGround()), _personalLighting(true), _cacheTile(0), _cacheTileBelow(0),
+	_cacheTileMask(0), _cacheUnit(0), _cacheUnitLoft(0), _cacheUnitBottom(0), _cacheUnitTop(0), _cacheUnitValid(false),
 	_maxViewDistance(mod->getMaxViewDistance()), _maxViewDistanceSq(_maxViewDistance * _maxViewDistance),
 	_maxVoxelViewDistance(_maxViewDistance * 16), _maxDarknessToSeeUnits(mod->getMaxDarknessToSeeUnits()),
 	_maxStaticLightDistance(mod->getMaxStaticLightDistance()), _maxDynamicLightDistance(mod->getMaxDynamicLightDistance()),
@@ -903,6 +948,11 @@ TileEngine::TileEngine(SavedBattleGame *save, Mod *mod) :
 	_blockVisibility.resize(save->getMapSizeXYZ());
 	_lightPropagationTerrainBlocking.resize(save->getMapSizeXYZ());
 	_lightPropagationTempNeedUpdate.resize(save->getMapSizeXYZ());
+	_lightTerrainSource.resize(save->getMapSizeXYZ());
+	_lightTerrainRoof.resize(save->getMapSizeXYZ());
+	_lightSourceCache.resize(LL_MAX);
+	_voxelTerrainMaskIndex.resize(save->getMapSizeXYZ(), voxelTerrainMaskDirty);
+	_voxelTerrainMasks.push_back(VoxelTerrainMask{}); // index 0 is reserved for tiles without any terrain voxels
 	_cacheTilePos = invalid;
 
 	if (Options::oxceTogglePersonalLightType == 2)
@@ -933,37 +983,40 @@ TileEngine::~TileEngine()
 
 /**
   * Calculates sun shading for the whole terrain.
+  * Goes down each column once, collecting roofs from terrain cache filled by calculateLighting.
   */
 void TileEngine::calculateSunShading(MapSubset gs)
 {
-	int power = 15 - _save->getGlobalShade();
+	const int power = 15 - _save->getGlobalShade();
+	// At night/dusk sun isn't dropping shades blocked by roofs
+	const bool roofShade = _save->getGlobalShade() <= 4;
 
-	iterateTiles(
-		_save,
-		gs,
-		[&](Tile* tile)
-		{
-			int currLight = power;
+	gs = MapSubset::intersection(gs, MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() });
+	if (!gs)
+	{
+		return;
+	}
 
-			// At night/dusk sun isn't dropping shades blocked by roofs
-			if (_save->getGlobalShade() <= 4)
+	std::vector<Uint8> roofAbove(gs.size_x() * gs.size_y(), 0);
+	for (int z = _save->getMapSizeZ() - 1; z >= 0; --z)
+	{
+		int column = 0;
+		for (int y = gs.beg_y; y < gs.end_y; ++y)
+		{
+			int index = _save->getTileIndex(Position(gs.beg_x, y, z));
+			Tile *tile = _save->getTile(index);
+			for (int x = gs.beg_x; x < gs.end_x; ++x, ++index, ++tile, ++column)
 			{
-				int block = 0;
-				int x = tile->getPosition().x;
-				int y = tile->getPosition().y;
-				for (int z = _save->getMapSizeZ()-1; z > tile->getPosition().z ; z--)
-				{
-					block += blockage(_save->getTile(Position(x, y, z)), O_FLOOR, DT_NONE);
-					block += blockage(_save->getTile(Position(x, y, z)), O_OBJECT, DT_NONE, Pathfinding::DIR_DOWN);
-				}
-				if (block>0)
+				int currLight = power;
+				if (roofShade && roofAbove[column])
 				{
 					currLight -= 2;
 				}
+				tile->addLight(currLight, LL_AMBIENT);
+				roofAbove[column] |= _lightTerrainRoof[index];
 			}
-			tile->addLight(currLight, LL_AMBIENT);
 		}
-	);
+	}
 }
 
 /// amount of light a fire generates from tile
@@ -984,26 +1037,9 @@ void TileEngine::calculateTerrainBackground(MapSubset gs)
 	iterateTiles(
 		_save,
 		mapAreaExpand(gs, getMaxStaticLightDistance() - 1),
-		[&](Tile* tile)
+		[&](Tile* tile, int index)
 		{
-			int currLight = 0;
-
-			if (tile->getMapData(O_FLOOR))
-			{
-				currLight = std::max(currLight, tile->getMapData(O_FLOOR)->getLightSource());
-			}
-			if (tile->getMapData(O_OBJECT))
-			{
-				currLight = std::max(currLight, tile->getMapData(O_OBJECT)->getLightSource());
-			}
-			if (tile->getMapData(O_WESTWALL))
-			{
-				currLight = std::max(currLight, tile->getMapData(O_WESTWALL)->getLightSource());
-			}
-			if (tile->getMapData(O_NORTHWALL))
-			{
-				currLight = std::max(currLight, tile->getMapData(O_NORTHWALL)->getLightSource());
-			}
+			int currLight = _lightTerrainSource[index];
 
 			// fires
 			if (tile->getFire())
@@ -1051,9 +1087,10 @@ void TileEngine::calculateTerrainItems(MapSubset gs)
 			{
 				currLight = getMaxDynamicLightDistance() - 1;
 			}
-			addLight(gs, tile->getPosition(), currLight, LL_ITEMS);
+			addLightCached(gs, tile->getPosition(), currLight, LL_ITEMS);
 		}
 	);
+	cleanLightCache(mapAreaExpand(gs, getMaxDynamicLightDistance() - 1), LL_ITEMS);
 }
 
 /**
@@ -1115,14 +1152,16 @@ void TileEngine::calculateUnitLighting(MapSubset gs)
 		{
 			for (int y = 0; y < size; ++y)
 			{
-				addLight(gs, pos + Position(x, y, 0), currLight, LL_UNITS);
+				addLightCached(gs, pos + Position(x, y, 0), currLight, LL_UNITS);
 			}
 		}
 	}
+	cleanLightCache(MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() }, LL_UNITS);
 }
 
 void TileEngine::calculateLighting(LightLayers layer, Position position, int eventRadius, bool terrianChanged)
 {
+	ProfilerScope scope("lighting");
 	const auto gsMap = MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() };
 	auto gsDynamic = gsMap;
 	auto gsStatic = gsDynamic;
@@ -1135,6 +1174,10 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 
 	if (terrianChanged)
 	{
+		if (position == invalid)
+		{
+			_blockVisibilityChangedAll = true;
+		}
 		iterateTiles(
 			_save,
 			position != invalid ? mapArea(position, eventRadius + 1) : gsMap,
@@ -1144,6 +1187,7 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 				const auto index = _save->getTileIndex(currPos);
 				const auto* mapData = tile->getMapData(O_OBJECT);
 				auto& cache = _blockVisibility[index];
+				const auto oldCache = cache;
 
 				cache = {};
 				cache.height = -tile->getTerrainLevel();
@@ -1178,6 +1222,40 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 					addBlockDir(cache, dir, -1, verticalBlockage(tile, tileNext, DT_NONE) > 127);
 				}
 
+				if (!_blockVisibilityChangedAll)
+				{
+					// fire and smoke do not block tile line of sight
+					const auto sightMask = ~(MaskFire | MaskSmoke);
+					if ((getBlockDir(oldCache) & sightMask) != (getBlockDir(cache) & sightMask) || oldCache.bigWall != cache.bigWall || oldCache.height != cache.height)
+					{
+						if (_blockVisibilityChangedMin == invalid)
+						{
+							_blockVisibilityChangedMin = currPos;
+							_blockVisibilityChangedMax = currPos;
+						}
+						else
+						{
+							_blockVisibilityChangedMin.x = std::min(_blockVisibilityChangedMin.x, currPos.x);
+							_blockVisibilityChangedMin.y = std::min(_blockVisibilityChangedMin.y, currPos.y);
+							_blockVisibilityChangedMin.z = std::min(_blockVisibilityChangedMin.z, currPos.z);
+							_blockVisibilityChangedMax.x = std::max(_blockVisibilityChangedMax.x, currPos.x);
+							_blockVisibilityChangedMax.y = std::max(_blockVisibilityChangedMax.y, currPos.y);
+							_blockVisibilityChangedMax.z = std::max(_blockVisibilityChangedMax.z, currPos.z);
+						}
+					}
+				}
+
+				int lightSource = 0;
+				for (int part = O_FLOOR; part < O_MAX; ++part)
+				{
+					if (tile->getMapData((TilePart)part))
+					{
+						lightSource = std::max(lightSource, tile->getMapData((TilePart)part)->getLightSource());
+					}
+				}
+				_lightTerrainSource[index] = std::min(lightSource, 255);
+				_lightTerrainRoof[index] = (blockage(tile, O_FLOOR, DT_NONE) + blockage(tile, O_OBJECT, DT_NONE, Pathfinding::DIR_DOWN)) > 0;
+
 				_lightPropagationTerrainBlocking[index] = getBlockDir(cache);
 				//HACK: some times light can lit wall objects even if its can't propagate through them,
 				// for simplicity we consider them transparent.
@@ -1225,6 +1303,16 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 		}
 	);
 
+	if (terrianChanged)
+	{
+		// traced light depends on terrain blockage
+		for (auto& cache : _lightSourceCache)
+		{
+			cache.clear();
+		}
+	}
+	++_lightSourceCacheTick;
+
 	if (layer <= LL_AMBIENT) calculateSunShading(gsStatic);
 	if (layer <= LL_FIRE) calculateTerrainBackground(gsStatic);
 	if (layer <= LL_ITEMS) calculateTerrainItems(gsDynamic);
@@ -1232,12 +1320,16 @@ void TileEngine::calculateLighting(LightLayers layer, Position position, int eve
 }
 
 /**
- * Adds circular light pattern starting from center and losing power with distance travelled.
+ * Traces circular light pattern starting from center and losing power with distance travelled.
+ * @param gs Part of map to light.
  * @param center Center.
  * @param power Power.
  * @param layer Light is separated in 4 layers: Ambient, Tiles, Items, Units.
+ * @param isolated Ignore light already on tiles and tiles outside of current update, result is light of this source alone.
+ * @param write Callback getting tile, its index, new light that should be added to it and light of both traced rays.
  */
-void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers layer)
+template<typename F>
+void TileEngine::traceLight(MapSubset gs, Position center, int power, LightLayers layer, bool isolated, F write)
 {
 	if (power <= 0)
 	{
@@ -1267,7 +1359,7 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			const auto target = tile->getPosition();
 			const auto diff = target - center;
 			const auto distance = (int)Round(Position::distance(target.toVoxel(), center.toVoxel()) / Position::TileXY);
-			const auto targetLight = tile->getLightMulti(layer);
+			const auto targetLight = isolated ? 0 : tile->getLightMulti(layer);
 			auto currLight = power - distance;
 
 			if (currLight <= targetLight)
@@ -1276,10 +1368,10 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			}
 			if (clasicLighting)
 			{
-				tile->addLight(currLight, layer);
+				write(tile, idx, currLight, currLight, currLight);
 				return;
 			}
-			if (_lightPropagationTempNeedUpdate[idx] == 0)
+			if (!isolated && _lightPropagationTempNeedUpdate[idx] == 0)
 			{
 				return;
 			}
@@ -1374,12 +1466,128 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
 			currLight = (lightA + lightB) / 2;
 			if (currLight > targetLight)
 			{
-				tile->addLight(currLight, layer);
+				write(tile, idx, currLight, lightA, lightB);
 			}
 		}
 	);
 }
 
+/**
+ * Adds circular light pattern starting from center and losing power with distance travelled.
+ * @param gs Part of map to light.
+ * @param center Center.
+ * @param power Power.
+ * @param layer Light is separated in 4 layers: Ambient, Tiles, Items, Units.
+ */
+void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers layer)
+{
+	traceLight(gs, center, power, layer, false,
+		[&](Tile* tile, int idx, int light, int lightA, int lightB)
+		{
+			tile->addLight(light, layer);
+		}
+	);
+}
+
+/**
+ * Adds light of a source that does not change often, like units or items.
+ * Light of the source alone is traced once and kept until the terrain changes,
+ * after that it is only copied to tiles that need update.
+ * Result is same as `addLight`: each ray is cut when its light drops below light already on the tile,
+ * and light only decreases along a ray, so the cut ray is the one that ended below that light.
+ * @param gs Part of map to light.
+ * @param center Center.
+ * @param power Power.
+ * @param layer Light is separated in 4 layers: Ambient, Tiles, Items, Units.
+ */
+void TileEngine::addLightCached(MapSubset gs, Position center, int power, LightLayers layer)
+{
+	if (power <= 0)
+	{
+		return;
+	}
+	if (!Options::oxceLightSourceCache)
+	{
+		addLight(gs, center, power, layer);
+		return;
+	}
+
+	const auto gsInter = MapSubset::intersection(gs, mapArea(center, power - 1));
+	auto& cache = _lightSourceCache[layer];
+	const auto key = LightSourceKey{ _save->getTileIndex(center), power };
+	auto it = cache.find(key);
+	if (it == cache.end())
+	{
+		if (!gsInter)
+		{
+			return;
+		}
+		it = cache.insert(std::make_pair(key, LightSourceCache{ center, _lightSourceCacheTick, { } })).first;
+		auto& tiles = it->second.tiles;
+		traceLight(mapArea(center, power - 1), center, power, layer, true,
+			[&](Tile* tile, int idx, int light, int lightA, int lightB)
+			{
+				tiles.push_back(LightSourceTile{ idx, (Sint16)lightA, (Sint16)lightB });
+			}
+		);
+	}
+	auto& source = it->second;
+	source.tick = _lightSourceCacheTick;
+	if (!gsInter)
+	{
+		return;
+	}
+
+	const auto clasicLighting = !(getEnhancedLighting() & ((layer == LL_FIRE ? 1 : 0) | (layer == LL_ITEMS ? 2 : 0) | (layer == LL_UNITS ? 4 : 0)));
+	const int sizeX = _save->getMapSizeX();
+	const int sizeY = _save->getMapSizeY();
+	for (const auto& t : source.tiles)
+	{
+		const int x = t.index % sizeX;
+		const int y = (t.index / sizeX) % sizeY;
+		if (x < gsInter.beg_x || x >= gsInter.end_x || y < gsInter.beg_y || y >= gsInter.end_y)
+		{
+			continue;
+		}
+		if (!clasicLighting && _lightPropagationTempNeedUpdate[t.index] == 0)
+		{
+			continue;
+		}
+		Tile *tile = _save->getTile(t.index);
+		const int targetLight = tile->getLightMulti(layer);
+		const int lightA = t.lightA < targetLight ? 0 : t.lightA;
+		const int lightB = t.lightB < targetLight ? 0 : t.lightB;
+		const int light = (lightA + lightB) / 2;
+		if (light > targetLight)
+		{
+			tile->addLight(light, layer);
+		}
+	}
+}
+
+/**
+ * Forgets kept light of sources that were not added since last call, in given part of map.
+ * @param gs Part of map where all sources of layer were added.
+ * @param layer Light layer.
+ */
+void TileEngine::cleanLightCache(MapSubset gs, LightLayers layer)
+{
+	gs = MapSubset::intersection(gs, MapSubset{ _save->getMapSizeX(), _save->getMapSizeY() });
+	auto& cache = _lightSourceCache[layer];
+	for (auto it = cache.begin(); it != cache.end(); )
+	{
+		const auto& c = it->second;
+		if (c.tick != _lightSourceCacheTick && c.center.x >= gs.beg_x && c.center.x < gs.end_x && c.center.y >= gs.beg_y && c.center.y < gs.end_y)
+		{
+			it = cache.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
 /**
  * Setups the internal event visibility search space reduction system. This system defines a narrow circle sector around
  * a given event as viewed from an external observer. This allows narrowing down which tiles/units may need to be updated for
@@ -1389,14 +1597,15 @@ void TileEngine::addLight(MapSubset gs, Position center, int power, LightLayers
  * @param observerPos Position of the observer of this event.
  * @param eventPos The centre of the event. Ie a moving unit's position, centre of explosion, a single destroyed tile, etc.
  * @param eventRadius Radius big enough to fully envelop the event. Ie for a single tile change, set radius to 1.
+ * @param sector Sector to setup.
  * @return true if area is unlimited.
  *
 */
-bool TileEngine::setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius)
+bool TileEngine::setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius, EventVisibilitySector &sector) const
 {
 	if (eventRadius == 0 || eventPos == Position(-1, -1, -1) || Position::distance2dSq(observerPos, eventPos) <= eventRadius * eventRadius)
 	{
-		_eventVisibilityObserverPos = Position{ -1, -1, -1 };
+		sector.observerPos = Position{ -1, -1, -1 };
 		return true;
 	}
 	else
@@ -1410,11 +1619,11 @@ bool TileEngine::setupEventVisibilitySector(const Position &observerPos, const P
 		float t1 = b - a;
 		float t2 = b + a;
 		//Define the points where the lines tangent to the circle intersect it. Note: resulting positions are relative to observer, not in direct tile space.
-		_eventVisibilitySectorL.x = roundf(eventPos.x + eventRadius * sinf(t1)) - observerPos.x;
-		_eventVisibilitySectorL.y = roundf(eventPos.y - eventRadius * cosf(t1)) - observerPos.y;
-		_eventVisibilitySectorR.x = roundf(eventPos.x - eventRadius * sinf(t2)) - observerPos.x;
-		_eventVisibilitySectorR.y = roundf(eventPos.y + eventRadius * cosf(t2)) - observerPos.y;
-		_eventVisibilityObserverPos = observerPos;
+		sector.sectorL.x = roundf(eventPos.x + eventRadius * sinf(t1)) - observerPos.x;
+		sector.sectorL.y = roundf(eventPos.y - eventRadius * cosf(t1)) - observerPos.y;
+		sector.sectorR.x = roundf(eventPos.x - eventRadius * sinf(t2)) - observerPos.x;
+		sector.sectorR.y = roundf(eventPos.y + eventRadius * cosf(t2)) - observerPos.y;
+		sector.observerPos = observerPos;
 		return false;
 	}
 }
@@ -1422,17 +1631,18 @@ bool TileEngine::setupEventVisibilitySector(const Position &observerPos, const P
 /**
  * Checks whether toCheck is within a previously setup eventVisibilitySector. See setupEventVisibilitySector(...).
  * May be used to rapidly reduce the search space when updating unit and tile visibility.
+ * @param sector The sector setup before.
  * @param toCheck The position to check.
  * @return true if within the circle sector.
  */
-inline bool TileEngine::inEventVisibilitySector(const Position &toCheck) const
+inline bool TileEngine::inEventVisibilitySector(const EventVisibilitySector &sector, const Position &toCheck)
 {
-	if (_eventVisibilityObserverPos != Position{ -1, -1, -1 })
+	if (sector.observerPos != Position{ -1, -1, -1 })
 	{
-		Position posDiff = toCheck - _eventVisibilityObserverPos;
+		Position posDiff = toCheck - sector.observerPos;
 		//Is toCheck within the arc as defined by the two tangent points?
-		return (!(-_eventVisibilitySectorL.x * posDiff.y + _eventVisibilitySectorL.y * posDiff.x > 0) &&
-			(-_eventVisibilitySectorR.x * posDiff.y + _eventVisibilitySectorR.y * posDiff.x > 0));
+		return (!(-sector.sectorL.x * posDiff.y + sector.sectorL.y * posDiff.x > 0) &&
+			(-sector.sectorR.x * posDiff.y + sector.sectorR.y * posDiff.x > 0));
 	}
 	else
 	{
@@ -1459,7 +1669,8 @@ bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos,
 		return false;
 
 	Position posSelf = unit->getPosition();
-	if (setupEventVisibilitySector(posSelf, eventPos, eventRadius))
+	EventVisibilitySector sector;
+	if (setupEventVisibilitySector(posSelf, eventPos, eventRadius, sector))
 	{
 		//Asked to do a full check. Or the event is overlapping our tile. Better check everything.
 		unit->clearVisibleUnits();
@@ -1478,7 +1689,7 @@ bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos,
 				{
 					Position posToCheck = posOther + Position(x, y, 0);
 					//If we can now find any unit within the arc defined by the event tangent points, its visibility may have been affected by the event.
-					if (inEventVisibilitySector(posToCheck))
+					if (inEventVisibilitySector(sector, posToCheck))
 					{
 						if (!unit->checkViewSector(posToCheck, useTurretDirection))
 						{
@@ -1530,50 +1741,41 @@ bool TileEngine::calculateUnitsInFOV(BattleUnit* unit, const Position eventPos,
 }
 
 /**
-* Calculates line of sight of tiles for a player controlled soldier.
-* If supplied with an event position differing from the soldier's position, it will only
-* calculate tiles within a narrow arc.
-* @param unit Unit to check line of sight of.
-* @param eventPos The centre of the event which necessitated the FOV update. Used to optimize which tiles to update.
-* @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
-*/
-void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius)
+ * Gets the direction a unit is looking in, taking the turret into account.
+ * @param unit Unit to check.
+ * @param useTurretDirection Set to true when the turret direction is used.
+ * @return View direction.
+ */
+static int getViewDirection(BattleUnit *unit, bool &useTurretDirection)
 {
-	bool useTurretDirection = false;
-	bool skipNarrowArcTest = false;
-	int direction;
 	if (Options::strafe && (unit->getTurretType() > -1)) {
-		direction = unit->getTurretDirection();
 		useTurretDirection = true;
+		return unit->getTurretDirection();
 	}
 	else
 	{
-		direction = unit->getDirection();
-	}
-	if (unit->getFaction() != FACTION_PLAYER || (eventRadius == 1 && !unit->checkViewSector(eventPos, useTurretDirection)))
-	{
-		//The event wasn't meant for us and/or visible for us.
-		return;
-	}
-	else if (unit->isOut())
-	{
-		unit->clearVisibleTiles();
-		return;
-	}
-	Position posSelf = unit->getPosition();
-	if (setupEventVisibilitySector(posSelf, eventPos, eventRadius))
-	{
-		//Asked to do a full check. Or unit within event. Should update all.
-		unit->clearVisibleTiles();
-		skipNarrowArcTest = true;
+		useTurretDirection = false;
+		return unit->getDirection();
 	}
+}
 
-	//Only recalculate bresenham lines to tiles that are at the event or further away.
-	const int distanceSqrMin = skipNarrowArcTest ? 0 : std::max(Position::distance2dSq(posSelf, eventPos) - eventRadius * eventRadius, 0);
+/**
+* Traces lines of sight from a unit to all tiles in its view cone.
+* Only reads the map, all tiles found visible are passed to the callback in a fixed order.
+* @param unit Unit to check line of sight of.
+* @param direction Direction the unit is looking in.
+* @param distanceSqrMin Tiles closer than this are skipped.
+* @param sector [Optional] Only check tiles in this sector, set up by setupEventVisibilitySector.
+* @param trajectory Buffer for the traced lines.
+* @param visit Callback called for each tile along the lines of sight.
+*/
+template<typename F>
+void TileEngine::iterateTilesInFOV(BattleUnit *unit, int direction, int distanceSqrMin, const EventVisibilitySector *sector, std::vector<Position> &trajectory, F visit)
+{
+	Position posSelf = unit->getPosition();
 
 	//Variables for finding the tiles to test based on the view direction.
 	Position posTest;
-	std::vector<Position> _trajectory;
 	bool swap = (direction == 0 || direction == 4);
 	const int signX[8] = { +1, +1, +1, +1, -1, -1, -1, -1 };
 	const int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
@@ -1608,7 +1810,7 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 				posTest.x = posSelf.x + signX[direction] * (swap ? y : x);
 				posTest.y = posSelf.y + signY[direction] * (swap ? x : y);
 				//Only continue if the column of tiles at (x,y) is within the narrow arc of interest (if enabled)
-				if (inEventVisibilitySector(posTest))
+				if (!sector || inEventVisibilitySector(*sector, posTest))
 				{
 					for (int z = 0; z < _save->getMapSizeZ(); z++)
 					{
@@ -1624,30 +1826,17 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 								for (int yo = 0; yo < size; yo++)
 								{
 									Position poso = posSelf + Position(xo, yo, 0);
-									_trajectory.clear();
-									int tst = calculateLineTile(poso, posTest, _trajectory);
+									trajectory.clear();
+									int tst = calculateLineTile(poso, posTest, trajectory);
 									if (tst > 127)
 									{
 										//Vision impacted something before reaching posTest. Throw away the impact point.
-										_trajectory.pop_back();
+										trajectory.pop_back();
 									}
 									//Reveal all tiles along line of vision. Note: needed due to width of bresenham stroke.
-									for (const auto& posVisited : _trajectory)
+									for (const auto& posVisited : trajectory)
 									{
-										//Add tiles to the visible list only once. BUT we still need to calculate the whole trajectory as
-										// this bresenham line's period might be different from the one that originally revealed the tile.
-										if (!unit->hasVisibleTile(_save->getTile(posVisited)))
-										{
-											unit->addToVisibleTiles(_save->getTile(posVisited));
-											_save->getTile(posVisited)->setVisible(+1);
-											_save->getTile(posVisited)->setDiscovered(true, O_FLOOR);
-
-											// walls to the east or south of a visible tile, we see that too
-											Tile* t = _save->getTile(Position(posVisited.x + 1, posVisited.y, posVisited.z));
-											if (t) t->setDiscovered(true, O_WESTWALL);
-											t = _save->getTile(Position(posVisited.x, posVisited.y + 1, posVisited.z));
-											if (t) t->setDiscovered(true, O_NORTHWALL);
-										}
+										visit(posVisited);
 									}
 								}
 							}
@@ -1659,6 +1848,132 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 	}
 }
 
+/**
+* Marks a tile as seen by a player unit, with the walls on its east and south sides.
+* @param unit Unit that sees the tile.
+* @param posVisited Position of the tile.
+*/
+void TileEngine::revealTileInFOV(BattleUnit *unit, Position posVisited)
+{
+	unit->addToVisibleTiles(_save->getTile(posVisited));
+	_save->getTile(posVisited)->setVisible(+1);
+	_save->getTile(posVisited)->setDiscovered(true, O_FLOOR);
+
+	// walls to the east or south of a visible tile, we see that too
+	Tile* t = _save->getTile(Position(posVisited.x + 1, posVisited.y, posVisited.z));
+	if (t) t->setDiscovered(true, O_WESTWALL);
+	t = _save->getTile(Position(posVisited.x, posVisited.y + 1, posVisited.z));
+	if (t) t->setDiscovered(true, O_NORTHWALL);
+}
+
+/**
+* Calculates line of sight of tiles for a player controlled soldier.
+* If supplied with an event position differing from the soldier's position, it will only
+* calculate tiles within a narrow arc.
+* @param unit Unit to check line of sight of.
+* @param eventPos The centre of the event which necessitated the FOV update. Used to optimize which tiles to update.
+* @param eventRadius The radius of a circle able to fully encompass the event, in tiles. Hence: 1 for a single tile event.
+*/
+void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius)
+{
+	prepareFOVBuffers();
+	std::vector<Position> visible;
+	FOVTilesUpdate update = collectTilesInFOV(unit, eventPos, eventRadius, false, visible, 0);
+	applyTilesInFOV(unit, update, visible);
+}
+
+/**
+* Makes sure every thread of the default pool has its own buffers for collectTilesInFOV.
+*/
+void TileEngine::prepareFOVBuffers()
+{
+	const size_t threads = ThreadPool::getDefault().getThreadCount();
+	if (_fovSeen.size() < threads)
+	{
+		_fovSeen.resize(threads);
+		_fovTrajectory.resize(threads);
+	}
+}
+
+/**
+* Collects tiles that calculateTilesInFOV would reveal to a unit, without changing anything.
+* Result is in the same order as calculateTilesInFOV would reveal them, each tile listed once.
+* Safe to call for different units from different threads at the same time, each with its own worker index.
+* @param unit Unit to check line of sight of.
+* @param eventPos The centre of the event which necessitated the FOV update.
+* @param eventRadius The radius of a circle able to fully encompass the event, in tiles.
+* @param cleared True when visible tiles of the unit will be cleared before the result is revealed.
+* @param visible Output list of tiles to reveal.
+* @param worker Index of thread, selects buffers from prepareFOVBuffers.
+* @return How visible tiles of the unit need to be updated.
+*/
+TileEngine::FOVTilesUpdate TileEngine::collectTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, bool cleared, std::vector<Position> &visible, int worker)
+{
+	visible.clear();
+	bool useTurretDirection = false;
+	int direction = getViewDirection(unit, useTurretDirection);
+	if (unit->getFaction() != FACTION_PLAYER || (eventRadius == 1 && !unit->checkViewSector(eventPos, useTurretDirection)))
+	{
+		//The event wasn't meant for us and/or visible for us.
+		return FOVTilesUpdate::None;
+	}
+	else if (unit->isOut())
+	{
+		return FOVTilesUpdate::Replace;
+	}
+	Position posSelf = unit->getPosition();
+	EventVisibilitySector sector;
+	//Asked to do a full check. Or unit within event. Should update all.
+	const bool skipNarrowArcTest = setupEventVisibilitySector(posSelf, eventPos, eventRadius, sector);
+	cleared = cleared || skipNarrowArcTest;
+
+	//Only recalculate bresenham lines to tiles that are at the event or further away.
+	const int distanceSqrMin = skipNarrowArcTest ? 0 : std::max(Position::distance2dSq(posSelf, eventPos) - eventRadius * eventRadius, 0);
+
+	auto& seen = _fovSeen[worker];
+	if (seen.size() != (size_t)_save->getMapSizeXYZ())
+	{
+		seen.assign(_save->getMapSizeXYZ(), false);
+	}
+	iterateTilesInFOV(unit, direction, distanceSqrMin, skipNarrowArcTest ? nullptr : &sector, _fovTrajectory[worker],
+		[&](Position posVisited)
+		{
+			//Add tiles to the visible list only once. BUT we still need to calculate the whole trajectory as
+			// this bresenham line's period might be different from the one that originally revealed the tile.
+			const int index = _save->getTileIndex(posVisited);
+			if (!seen[index] && (cleared || !unit->hasVisibleTile(_save->getTile(posVisited))))
+			{
+				seen[index] = true;
+				visible.push_back(posVisited);
+			}
+		}
+	);
+	// only listed tiles were marked, unmark them for the next unit
+	for (const auto& posVisited : visible)
+	{
+		seen[_save->getTileIndex(posVisited)] = false;
+	}
+	return skipNarrowArcTest ? FOVTilesUpdate::Replace : FOVTilesUpdate::Append;
+}
+
+/**
+* Updates visible tiles of a unit with the result of collectTilesInFOV.
+* @param unit Unit to update.
+* @param update How visible tiles need to be updated.
+* @param visible Tiles to reveal.
+*/
+void TileEngine::applyTilesInFOV(BattleUnit *unit, FOVTilesUpdate update, const std::vector<Position> &visible)
+{
+	if (update == FOVTilesUpdate::Replace)
+	{
+		unit->clearVisibleTiles();
+	}
+	for (const auto& posVisited : visible)
+	{
+		revealTileInFOV(unit, posVisited);
+	}
+}
+
 /**
 * Recalculates line of sight of a soldier.
 * @param unit Unit to check line of sight of.
@@ -1668,6 +1983,7 @@ void TileEngine::calculateTilesInFOV(BattleUnit *unit, const Position eventPos,
 */
 bool TileEngine::calculateFOV(BattleUnit *unit, bool doTileRecalc, bool doUnitRecalc)
 {
+	ProfilerScope scope("unit fov");
 	//Force a full FOV recheck for this unit.
 	if (doTileRecalc) calculateTilesInFOV(unit);
 	return doUnitRecalc ? calculateUnitsInFOV(unit) : false;
@@ -2099,7 +2415,6 @@ int TileEngine::checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit
 {
 	Position targetVoxel = tile->getPosition().toVoxel() + Position(8, 8, 0);
 	Position scanVoxel;
-	std::vector<Position> _trajectory;
 	BattleUnit *otherUnit = tile->getUnit();
 	if (otherUnit == 0) return 0; //no unit in this tile, even if it elevated and appearing in it.
 	if (otherUnit == excludeUnit) return 0; //skip self
@@ -2136,6 +2451,8 @@ int TileEngine::checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit
 
 	int targetMaxHeight=targetMinHeight+heightRange;
 	// scan ray from top to bottom  plus different parts of target cylinder
+	std::vector<VoxelRay> rays;
+	rays.reserve((heightRange / 2 + 1) * 3);
 	int total=0;
 	int visible=0;
 	for (int i = heightRange; i >=0; i-=2)
@@ -2146,18 +2463,21 @@ int TileEngine::checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit
 		{
 			scanVoxel.x=targetVoxel.x + sliceTargets[j*2];
 			scanVoxel.y=targetVoxel.y + sliceTargets[j*2+1];
-			_trajectory.clear();
-			int test = calculateLineVoxel(*originVoxel, scanVoxel, false, &_trajectory, excludeUnit, excludeAllBut);
-			if (test == V_UNIT)
-			{
-				//voxel of hit must be inside of scanned box
-				if (_trajectory.at(0).x/16 == scanVoxel.x/16 &&
-					_trajectory.at(0).y/16 == scanVoxel.y/16 &&
-					_trajectory.at(0).z >= targetMinHeight &&
-					_trajectory.at(0).z <= targetMaxHeight)
-				{
-					++visible;
-				}
+			rays.push_back(VoxelRay{ scanVoxel, V_EMPTY, invalid });
+		}
+	}
+	calculateLineVoxelBatch(*originVoxel, rays.data(), (int)rays.size(), excludeUnit, excludeAllBut);
+	for (const auto& ray : rays)
+	{
+		if (ray.type == V_UNIT)
+		{
+			//voxel of hit must be inside of scanned box
+			if (ray.impact.x/16 == ray.target.x/16 &&
+				ray.impact.y/16 == ray.target.y/16 &&
+				ray.impact.z >= targetMinHeight &&
+				ray.impact.z <= targetMaxHeight)
+			{
+				++visible;
 			}
 		}
 	}
@@ -2177,7 +2497,6 @@ int TileEngine::checkVoxelExposure(Position *originVoxel, Tile *tile, BattleUnit
 bool TileEngine::canTargetUnit(Position *originVoxel, Tile *tile, Position *scanVoxel, BattleUnit *excludeUnit, bool rememberObstacles, BattleUnit *potentialUnit)
 {
 	Position targetVoxel = tile->getPosition().toVoxel() + Position(8, 8, 0);
-	std::vector<Position> _trajectory;
 	bool hypothetical = potentialUnit != 0;
 	if (potentialUnit == 0)
 	{
@@ -2226,42 +2545,58 @@ bool TileEngine::canTargetUnit(Position *originVoxel, Tile *tile, Position *scan
 	if (heightRange>10) heightRange=10;
 	if (heightRange<=0) heightRange=0;
 
-	// scan ray from top to bottom  plus different parts of target cylinder
-	for (int i = 0; i <= heightRange; ++i)
+	// ray that ends the search
+	auto hitTarget = [&](const VoxelRay& ray)
 	{
-		scanVoxel->z=targetCenterHeight+heightFromCenter[i];
-		for (int j = 0; j < 5; ++j)
+		if (ray.type == V_UNIT)
 		{
-			if (i < (heightRange-1) && j>2) break; //skip unnecessary checks
-			scanVoxel->x=targetVoxel.x + sliceTargets[j*2];
-			scanVoxel->y=targetVoxel.y + sliceTargets[j*2+1];
-			_trajectory.clear();
-			int test = calculateLineVoxel(*originVoxel, *scanVoxel, false, &_trajectory, excludeUnit);
-			if (test == V_UNIT)
+			for (int x = 0; x <= targetSize; ++x)
 			{
-				for (int x = 0; x <= targetSize; ++x)
+				for (int y = 0; y <= targetSize; ++y)
 				{
-					for (int y = 0; y <= targetSize; ++y)
+					//voxel of hit must be inside of scanned box
+					if (ray.impact.x/16 == (ray.target.x/16) + x + xOffset &&
+						ray.impact.y/16 == (ray.target.y/16) + y + yOffset &&
+						ray.impact.z >= targetMinHeight &&
+						ray.impact.z <= targetMaxHeight)
 					{
-						//voxel of hit must be inside of scanned box
-						if (_trajectory.at(0).x/16 == (scanVoxel->x/16) + x + xOffset &&
-							_trajectory.at(0).y/16 == (scanVoxel->y/16) + y + yOffset &&
-							_trajectory.at(0).z >= targetMinHeight &&
-							_trajectory.at(0).z <= targetMaxHeight)
-						{
-							return true;
-						}
+						return true;
 					}
 				}
 			}
-			else if (test == V_EMPTY && hypothetical && !_trajectory.empty())
+		}
+		else if (ray.type == V_EMPTY && hypothetical && ray.impact != invalid)
+		{
+			return true;
+		}
+		return false;
+	};
+
+	// scan ray from top to bottom  plus different parts of target cylinder
+	for (int i = 0; i <= heightRange; ++i)
+	{
+		// all rays of one level are traced together, but checked in same order as before,
+		// tracing stops as soon as one of them reaches the target
+		VoxelRay rays[5];
+		int count = 0;
+		for (int j = 0; j < 5; ++j)
+		{
+			if (i < (heightRange-1) && j>2) break; //skip unnecessary checks
+			rays[count++].target = Position(targetVoxel.x + sliceTargets[j*2], targetVoxel.y + sliceTargets[j*2+1], targetCenterHeight+heightFromCenter[i]);
+		}
+		calculateLineVoxelBatch(*originVoxel, rays, count, [&](int r){ return hitTarget(rays[r]); }, excludeUnit);
+		for (int r = 0; r < count; ++r)
+		{
+			const auto& ray = rays[r];
+			*scanVoxel = ray.target;
+			if (hitTarget(ray))
 			{
 				return true;
 			}
-			if (rememberObstacles && _trajectory.size()>0)
+			if (rememberObstacles && ray.impact != invalid)
 			{
-				Tile *tileObstacle = _save->getTile(_trajectory.at(0).toTile());
-				if (tileObstacle) tileObstacle->setObstacle(test);
+				Tile *tileObstacle = _save->getTile(ray.impact.toTile());
+				if (tileObstacle) tileObstacle->setObstacle(ray.type);
 			}
 		}
 	}
@@ -2451,6 +2786,7 @@ bool TileEngine::canTargetTile(Position *originVoxel, Tile *tile, int part, Posi
  */
 void TileEngine::calculateFOV(Position position, int eventRadius, const bool updateTiles, const bool appendToTileVisibility)
 {
+	ProfilerScope scope("fov");
 	int updateRadius;
 	if (eventRadius == -1)
 	{
@@ -2463,17 +2799,84 @@ void TileEngine::calculateFOV(Position position, int eventRadius, const bool upd
 		updateRadius = getMaxViewDistance() + (eventRadius > 0 ? eventRadius : 0);
 		updateRadius *= updateRadius;
 	}
+
+	//When only appending new tiles, only lines going through tiles that changed visibility blockage can reveal anything.
+	Position tilesPosition = position;
+	int tilesRadius = eventRadius;
+	bool skipTiles = false;
+	if (updateTiles && appendToTileVisibility && !_blockVisibilityChangedAll)
+	{
+		if (_blockVisibilityChangedMin == invalid)
+		{
+			skipTiles = true;
+		}
+		else
+		{
+			const Position min = _blockVisibilityChangedMin;
+			const Position max = _blockVisibilityChangedMax;
+			const Position center = Position((min.x + max.x) / 2, (min.y + max.y) / 2, (min.z + max.z) / 2);
+			const int halfX = max.x - center.x;
+			const int halfY = max.y - center.y;
+			const int radius = (int)ceilf(sqrtf(halfX * halfX + halfY * halfY)) + 1;
+			if (radius < eventRadius)
+			{
+				tilesPosition = center;
+				tilesRadius = radius;
+			}
+		}
+	}
+	if (updateTiles)
+	{
+		_blockVisibilityChangedMin = invalid;
+		_blockVisibilityChangedMax = invalid;
+		_blockVisibilityChangedAll = false;
+	}
+
+	ThreadPool &pool = ThreadPool::getDefault();
+	if (updateTiles && !skipTiles && pool.getThreadCount() > 1)
+	{
+		// Same as the serial loop below, with lines of sight to tiles traced for all units at once.
+		auto& units = *_save->getUnits();
+		std::vector<std::vector<Position>> visible(units.size());
+		std::vector<FOVTilesUpdate> updates(units.size(), FOVTilesUpdate::None);
+		prepareFOVBuffers();
+		pool.parallelFor((int)units.size(),
+			[&](int i, int worker)
+			{
+				BattleUnit *bu = units[i];
+				if (Position::distance2dSq(position, bu->getPosition()) <= updateRadius)
+				{
+					updates[i] = collectTilesInFOV(bu, tilesPosition, tilesRadius, !appendToTileVisibility, visible[i], worker);
+				}
+			}
+		);
+		for (size_t i = 0; i < units.size(); ++i)
+		{
+			BattleUnit *bu = units[i];
+			if (Position::distance2dSq(position, bu->getPosition()) <= updateRadius)
+			{
+				if (!appendToTileVisibility)
+				{
+					bu->clearVisibleTiles();
+				}
+				applyTilesInFOV(bu, updates[i], visible[i]);
+				calculateUnitsInFOV(bu, position, eventRadius);
+			}
+		}
+		return;
+	}
+
 	for (auto* bu : *_save->getUnits())
 	{
 		if (Position::distance2dSq(position, bu->getPosition()) <= updateRadius) //could this unit have observed the event?
 		{
-			if (updateTiles)
+			if (updateTiles && !skipTiles)
 			{
 				if (!appendToTileVisibility)
 				{
 					bu->clearVisibleTiles();
 				}
-				calculateTilesInFOV(bu, position, eventRadius);
+				calculateTilesInFOV(bu, tilesPosition, tilesRadius);
 			}
 
 			calculateUnitsInFOV(bu, position, eventRadius);
@@ -4354,6 +4757,7 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 	{
 		excludeAllUnits = true; // don't start unit spotting before pre-game inventory stuff (large units on the craftInventory tile will cause a crash if they're "spotted")
 	}
+	voxelCheckFlush(); // units could move since last time
 
 	bool hit = calculateLineHelper(origin, target,
 		[&](Position point)
@@ -4396,6 +4800,67 @@ VoxelType TileEngine::calculateLineVoxel(Position origin, Position target, bool
 	return V_EMPTY;
 }
 
+/**
+ * Calculates many line trajectories from the same origin.
+ * Each ray stops on its own first hit and visits exactly same voxels as `calculateLineVoxel`.
+ * @param origin Origin in voxel.
+ * @param rays Rays to trace, `target` need be set, other fields are filled with results.
+ * @param count Number of rays.
+ * @param excludeUnit Excludes this unit in the collision detection.
+ * @param excludeAllBut [Optional] The only unit to be considered for ray hits.
+ * @param onlyVisible Skip invisible units?
+ */
+void TileEngine::calculateLineVoxelBatch(Position origin, VoxelRay *rays, int count, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible)
+{
+	calculateLineVoxelBatch(origin, rays, count, [](int){ return false; }, excludeUnit, excludeAllBut, onlyVisible);
+}
+
+/**
+ * Calculates many line trajectories from the same origin.
+ * Rays are traced one after another, each to its end, so `voxelCheck` keeps its cached tile for whole run of voxels in it.
+ * When `rayDone` accepts a finished ray, rays after it are not traced and their results should not be used.
+ * This allows stopping as soon as the first ray in order is known to be good enough.
+ * @param origin Origin in voxel.
+ * @param rays Rays to trace, `target` need be set, other fields are filled with results.
+ * @param count Number of rays.
+ * @param rayDone Called with index of each ray when it is finished, returns true to skip all rays after it.
+ * @param excludeUnit Excludes this unit in the collision detection.
+ * @param excludeAllBut [Optional] The only unit to be considered for ray hits.
+ * @param onlyVisible Skip invisible units?
+ */
+void TileEngine::calculateLineVoxelBatch(Position origin, VoxelRay *rays, int count, FuncRef<bool(int index)> rayDone, BattleUnit *excludeUnit, BattleUnit *excludeAllBut, bool onlyVisible)
+{
+	bool excludeAllUnits = false;
+	if (_save->isBeforeGame())
+	{
+		excludeAllUnits = true; // don't start unit spotting before pre-game inventory stuff
+	}
+	voxelCheckFlush(); // units could move since last time
+
+	for (int i = 0; i < count; ++i)
+	{
+		auto& ray = rays[i];
+		ray.type = V_EMPTY;
+		ray.impact = invalid;
+		auto check = [&](Position point)
+		{
+			VoxelType result = voxelCheck(point, excludeUnit, excludeAllUnits, onlyVisible, excludeAllBut);
+			if (result != V_EMPTY)
+			{
+				ray.type = result;
+				ray.impact = point;
+				return true;
+			}
+			return false;
+		};
+		calculateLineHelper(origin, ray.target, check, check);
+		if (rayDone(i))
+		{
+			return;
+		}
+	}
+}
+
 /**
  * Calculates a parabola trajectory, used for throwing items.
  * @param origin Origin in voxelspace.
@@ -4507,45 +4972,106 @@ bool TileEngine::isVoxelVisible(Position voxel)
 }
 
 /**
- * Checks if we hit a voxel.
- * @param voxel The voxel to check.
- * @param excludeUnit Don't do checks on this unit.
- * @param excludeAllUnits Don't do checks on any unit.
- * @param onlyVisible Whether to consider only visible units.
- * @param excludeAllBut If set, the only unit to be considered for ray hits.
- * @return The objectnumber(0-3) or unit(4) or out of map (5) or -1 (hit nothing).
+ * Gets compiled terrain voxel mask of tile, building it if tile terrain changed since last time.
+ * Tiles with same terrain parts share one mask.
+ * @param tile The tile.
+ * @return Voxel mask of all terrain parts of the tile.
  */
-VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut)
+const TileEngine::VoxelTerrainMask &TileEngine::getVoxelTerrainMask(Tile *tile)
 {
-	if (voxel.x < 0 || voxel.y < 0 || voxel.z < 0) //preliminary out of map
+	auto& index = _voxelTerrainMaskIndex[_save->getTileIndex(tile->getPosition())];
+	if (index != voxelTerrainMaskDirty)
 	{
-		return V_OUTOFBOUNDS;
+		return _voxelTerrainMasks[index];
 	}
-	Position pos = voxel.toTile();
-	Tile *tile, *tileBelow;
-	if (_cacheTilePos == pos)
+
+	const MapData* parts[O_MAX] = { };
+	bool empty = true;
+	for (int i = V_FLOOR; i <= V_OBJECT; ++i)
 	{
-		tile = _cacheTile;
-		tileBelow = _cacheTileBelow;
+		TilePart tp = (TilePart)i;
+		if (((tp == O_WESTWALL) || (tp == O_NORTHWALL)) && tile->isUfoDoorOpen(tp))
+			continue;
+		parts[i] = tile->getMapData(tp);
+		empty = empty && parts[i] == nullptr;
 	}
-	else
+	Tile *tileBelow = _save->getBelowTile(tile);
+	const bool gravLiftFloor = tile->hasGravLiftFloor() && !(tileBelow && tileBelow->hasGravLiftFloor());
+
+	if (empty)
 	{
-		tile = _save->getTile(pos);
-		if (!tile) // check if we are not out of the map
+		index = 0;
+		return _voxelTerrainMasks[index];
+	}
+
+	const auto key = VoxelTerrainKey{ parts[O_FLOOR], parts[O_WESTWALL], parts[O_NORTHWALL], parts[O_OBJECT], gravLiftFloor };
+	auto it = _voxelTerrainMasksLookup.find(key);
+	if (it != _voxelTerrainMasksLookup.end())
+	{
+		index = it->second;
+		return _voxelTerrainMasks[index];
+	}
+
+	VoxelTerrainMask mask = { };
+	for (int layer = 0; layer < Position::TileZ / 2; ++layer)
+	{
+		for (int i = V_FLOOR; i <= V_OBJECT; ++i)
 		{
-			return V_OUTOFBOUNDS; //not even cache
+			if (parts[i] != 0)
+			{
+				int idx = parts[i]->getLoftID(layer) * 16;
+				for (int y = 0; y < Position::TileXY; ++y)
+				{
+					mask.rows[layer][y] |= _voxelData->at(idx + y);
+				}
+			}
 		}
-		tileBelow = _save->getBelowTile(tile);
-		_cacheTilePos = pos;
-		_cacheTile = tile;
-		_cacheTileBelow = tileBelow;
- 	}
+	}
+	if (gravLiftFloor)
+	{
+		// whole bottom layer behave like floor
+		for (int y = 0; y < Position::TileXY; ++y)
+		{
+			mask.rows[0][y] = 0xFFFF;
+		}
+	}
+
+	index = (Uint32)_voxelTerrainMasks.size();
+	_voxelTerrainMasks.push_back(mask);
+	_voxelTerrainMasksLookup.insert(std::make_pair(key, index));
+	return _voxelTerrainMasks[index];
+}
+
+/**
+ * Marks terrain voxel mask of tile as outdated, need be called when map data or ufo door state of tile change.
+ * @param tile The tile that changed.
+ */
+void TileEngine::voxelTerrainInvalidate(Tile *tile)
+{
+	_voxelTerrainMaskIndex[_save->getTileIndex(tile->getPosition())] = voxelTerrainMaskDirty;
 
-	if (tile->isVoid() && tile->getUnit() == 0 && (!tileBelow || tileBelow->getUnit() == 0))
+	// grav lift floor of tile above depends on this tile floor
+	Tile *tileAbove = _save->getAboveTile(tile);
+	if (tileAbove)
 	{
-		return V_EMPTY;
+		_voxelTerrainMaskIndex[_save->getTileIndex(tileAbove->getPosition())] = voxelTerrainMaskDirty;
 	}
 
+	if (_cacheTile == tile || _cacheTileBelow == tile)
+	{
+		voxelCheckFlush();
+	}
+}
+
+/**
+ * Checks which terrain part occupies a voxel, used only after terrain voxel mask reports hit.
+ * @param tile Tile of voxel.
+ * @param tileBelow Tile below.
+ * @param voxel The voxel to check.
+ * @return The objectnumber(0-3) or -1 (hit nothing).
+ */
+VoxelType TileEngine::voxelCheckTerrain(Tile *tile, Tile *tileBelow, Position voxel) const
+{
 	if (tile->hasGravLiftFloor() && (voxel.z % 24 == 0 || voxel.z % 24 == 1))
 	{
 		if (!(tileBelow && tileBelow->hasGravLiftFloor()))
@@ -4572,41 +5098,109 @@ VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool e
 			}
 		}
 	}
+	return V_EMPTY;
+}
 
-	if (!excludeAllUnits)
+/**
+ * Fills cache with unit overlapping cached tile, its vertical range and loft.
+ */
+void TileEngine::voxelCheckCacheUnit()
+{
+	_cacheUnitValid = true;
+	_cacheUnit = 0;
+	_cacheUnitLoft = 0;
+
+	BattleUnit *unit = _cacheTile->getOverlappingUnit(_save);
+	if (unit == 0 || unit->isOut())
 	{
-		BattleUnit *unit = tile->getOverlappingUnit(_save);
+		return;
+	}
 
-		if (unit != 0 && !unit->isOut() && unit != excludeUnit && (!excludeAllBut || unit == excludeAllBut) && (!onlyVisible || unit->getVisible() ) )
+	Position tilepos;
+	Position unitpos = unit->getPosition();
+	int terrainHeight = 0;
+	for (int x = 0; x < unit->getArmor()->getSize(); ++x)
+	{
+		for (int y = 0; y < unit->getArmor()->getSize(); ++y)
 		{
-			Position tilepos;
-			Position unitpos = unit->getPosition();
-			int terrainHeight = 0;
-			for (int x = 0; x < unit->getArmor()->getSize(); ++x)
+			Tile *tempTile = _save->getTile(unitpos + Position(x,y,0));
+			if (tempTile->getTerrainLevel() < terrainHeight)
 			{
-				for (int y = 0; y < unit->getArmor()->getSize(); ++y)
-				{
-					Tile *tempTile = _save->getTile(unitpos + Position(x,y,0));
-					if (tempTile->getTerrainLevel() < terrainHeight)
-					{
-						terrainHeight = tempTile->getTerrainLevel();
-					}
-				}
+				terrainHeight = tempTile->getTerrainLevel();
 			}
-			int tz = unitpos.z*24 + unit->getFloatHeight() - terrainHeight; //bottom most voxel, terrain heights are negative, so we subtract.
-			if ((voxel.z > tz) && (voxel.z <= tz + unit->getHeight()) )
+		}
+	}
+	int part = 0;
+	if (unit->isBigUnit())
+	{
+		tilepos = _cacheTile->getPosition();
+		const static int parts[] = {1,0,3,2}; // Change order 0,1,2,3 -> 1,0,3,2  (read commit description)
+		part = parts[tilepos.x - unitpos.x + (tilepos.y - unitpos.y)*2];
+	}
+	int idx = unit->getLoftemps(part) * 16;
+	_cacheUnit = unit;
+	_cacheUnitLoft = &_voxelData->at(idx);
+	_cacheUnitBottom = unitpos.z*24 + unit->getFloatHeight() - terrainHeight; //bottom most voxel, terrain heights are negative, so we subtract.
+	_cacheUnitTop = _cacheUnitBottom + unit->getHeight();
+}
+
+/**
+ * Checks if we hit a voxel.
+ * Terrain is checked using precompiled voxel mask of tile, units are checked after it using unit data cached for current tile.
+ * @param voxel The voxel to check.
+ * @param excludeUnit Don't do checks on this unit.
+ * @param excludeAllUnits Don't do checks on any unit.
+ * @param onlyVisible Whether to consider only visible units.
+ * @param excludeAllBut If set, the only unit to be considered for ray hits.
+ * @return The objectnumber(0-3) or unit(4) or out of map (5) or -1 (hit nothing).
+ */
+VoxelType TileEngine::voxelCheck(Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits, bool onlyVisible, BattleUnit *excludeAllBut)
+{
+	if (voxel.x < 0 || voxel.y < 0 || voxel.z < 0) //preliminary out of map
+	{
+		return V_OUTOFBOUNDS;
+	}
+	Position pos = voxel.toTile();
+	if (_cacheTilePos != pos)
+	{
+		Tile *tile = _save->getTile(pos);
+		if (!tile) // check if we are not out of the map
+		{
+			return V_OUTOFBOUNDS; //not even cache
+		}
+		_cacheTilePos = pos;
+		_cacheTile = tile;
+		_cacheTileBelow = _save->getBelowTile(tile);
+		_cacheTileMask = &getVoxelTerrainMask(tile);
+		_cacheUnitValid = false;
+ 	}
+
+	const int x = 15 - voxel.x%16;
+	const int y = voxel.y%16;
+
+	// first we check terrain voxel data, not to allow 2x2 units stick through walls
+	if (_cacheTileMask->rows[(voxel.z%24)/2][y] & (1 << x))
+	{
+		VoxelType result = voxelCheckTerrain(_cacheTile, _cacheTileBelow, voxel);
+		if (result != V_EMPTY)
+		{
+			return result;
+		}
+	}
+
+	if (!excludeAllUnits)
+	{
+		if (!_cacheUnitValid)
+		{
+			voxelCheckCacheUnit();
+		}
+
+		BattleUnit *unit = _cacheUnit;
+		if (unit != 0 && unit != excludeUnit && (!excludeAllBut || unit == excludeAllBut) && (!onlyVisible || unit->getVisible() ) )
+		{
+			if ((voxel.z > _cacheUnitBottom) && (voxel.z <= _cacheUnitTop) )
 			{
-				int x = 15 - voxel.x%16;
-				int y = voxel.y%16;
-				int part = 0;
-				if (unit->isBigUnit())
-				{
-					tilepos = tile->getPosition();
-					const static int parts[] = {1,0,3,2}; // Change order 0,1,2,3 -> 1,0,3,2  (read commit description)
-					part = parts[tilepos.x - unitpos.x + (tilepos.y - unitpos.y)*2];
-				}
-				int idx = (unit->getLoftemps(part) * 16) + y;
-				if (_voxelData->at(idx) & (1 << x))
+				if (_cacheUnitLoft[y] & (1 << x))
 				{
 					return V_UNIT;
 				}
@@ -4621,6 +5215,8 @@ void TileEngine::voxelCheckFlush()
 	_cacheTilePos = invalid;
 	_cacheTile = 0;
 	_cacheTileBelow = 0;
+	_cacheTileMask = 0;
+	_cacheUnitValid = false;
 }
 
 /**
@@ -5732,6 +6328,42 @@ bool TileEngine::validateThrow(BattleAction &action, Position originVoxel, Posit
  */
 void TileEngine::recalculateFOV()
 {
+	ProfilerScope scope("fov");
+	_blockVisibilityChangedMin = invalid;
+	_blockVisibilityChangedMax = invalid;
+	_blockVisibilityChangedAll = false;
+
+	ThreadPool &pool = ThreadPool::getDefault();
+	if (pool.getThreadCount() > 1)
+	{
+		// Tracing lines of sight to tiles only reads the map, do it for all units at once
+		// and then reveal the tiles in unit order, giving the same result as the serial loop.
+		auto& units = *_save->getUnits();
+		std::vector<std::vector<Position>> visible(units.size());
+		std::vector<FOVTilesUpdate> updates(units.size(), FOVTilesUpdate::None);
+		prepareFOVBuffers();
+		pool.parallelFor((int)units.size(),
+			[&](int i, int worker)
+			{
+				BattleUnit *bu = units[i];
+				if (bu->getTile() != 0)
+				{
+					updates[i] = collectTilesInFOV(bu, invalid, 0, false, visible[i], worker);
+				}
+			}
+		);
+		for (size_t i = 0; i < units.size(); ++i)
+		{
+			BattleUnit *bu = units[i];
+			if (bu->getTile() != 0)
+			{
+				applyTilesInFOV(bu, updates[i], visible[i]);
+				calculateUnitsInFOV(bu);
+			}
+		}
+		return;
+	}
+
 	for (auto* bu : *_save->getUnits())
 	{
 		if (bu->getTile() != 0)
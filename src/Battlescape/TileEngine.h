@@ -18,10 +18,13 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <vector>
+#include <map>
+#include <tuple>
 #include "Position.h"
 #include "BattlescapeGame.h"
 #include "../Mod/RuleItem.h"
 #include "../Mod/MapData.h"
+#include "../Engine/Functions.h"
 
 namespace OpenXcom
 {
@@ -59,6 +62,19 @@ public:
 	/// Half of size of tile in voxels
 	static constexpr Position voxelTileCenter = { Position::TileXY / 2, Position::TileXY / 2, Position::TileZ / 2 };
 
+	/**
+	 * Single ray of `calculateLineVoxelBatch`.
+	 */
+	struct VoxelRay
+	{
+		/// End of ray, set by caller.
+		Position target;
+		/// What ray hit.
+		VoxelType type;
+		/// Voxel where ray hit something, `invalid` if nothing was hit.
+		Position impact;
+	};
+
 	/// Calculate distance of each step of trajectory.
 	static float trajectoryStepSize(const std::vector<Position>& voxelPath, size_t pos)
 	{
@@ -89,6 +105,67 @@ private:
 		Uint8 height;
 	};
 
+	/**
+	 * Helper class storing compiled terrain voxel occupancy of a tile.
+	 */
+	struct VoxelTerrainMask
+	{
+		/// Union of voxels of all tile parts, one row of 16 voxels for each loft layer and y position.
+		Uint16 rows[Position::TileZ / 2][Position::TileXY];
+	};
+
+	/// Tile parts used to build terrain voxel mask, with flag of grav lift floor.
+	using VoxelTerrainKey = std::tuple<const MapData*, const MapData*, const MapData*, const MapData*, bool>;
+
+	/// Index value of tile that need rebuild of its terrain voxel mask.
+	constexpr static Uint32 voxelTerrainMaskDirty = (Uint32)-1;
+
+	/**
+	 * Light of one source alone on one tile.
+	 */
+	struct LightSourceTile
+	{
+		int index;
+		/// Light at the end of both rays traced to the tile, same values for classic lighting.
+		Sint16 lightA, lightB;
+	};
+
+	/**
+	 * Helper class storing light of one source alone.
+	 */
+	struct LightSourceCache
+	{
+		Position center;
+		/// Last lighting update that used this source.
+		Uint32 tick;
+		/// Lit tiles.
+		std::vector<LightSourceTile> tiles;
+	};
+
+	/// Key of light source: tile index of center and power.
+	using LightSourceKey = std::pair<int, int>;
+
+	/**
+	 * Narrow circle sector around an event as viewed from an observer, see setupEventVisibilitySector.
+	 */
+	struct EventVisibilitySector
+	{
+		Position sectorL, sectorR, observerPos;
+	};
+
+	/**
+	 * How visible tiles of a unit change in an update of its line of sight.
+	 */
+	enum class FOVTilesUpdate
+	{
+		/// Nothing changes.
+		None,
+		/// Collected tiles are added to visible ones.
+		Append,
+		/// Visible tiles are cleared and replaced by collected ones.
+		Replace,
+	};
+
 	/**
 	 * Helper class storing reaction data.
 	 */
@@ -107,10 +184,28 @@ private:
 
 	/// Cache for tile visibility and light propagation.
 	std::vector<VisibilityBlockCache> _blockVisibility;
+	/// Bounding box of tiles that changed visibility blockage since last update of tiles in FOV, `invalid` when none changed.
+	Position _blockVisibilityChangedMin = invalid, _blockVisibilityChangedMax = invalid;
+	/// Visibility blockage of whole map changed since last update of tiles in FOV.
+	bool _blockVisibilityChangedAll = true;
 	/// Cache dedicated for speedup for light propagation calculation.
 	std::vector<Uint32> _lightPropagationTerrainBlocking;
 	/// Cache for marking tiles that need light updated.
 	std::vector<Uint32> _lightPropagationTempNeedUpdate;
+	/// Strongest light source of terrain parts of each tile, for calculateTerrainBackground.
+	std::vector<Uint8> _lightTerrainSource;
+	/// Does tile shade tiles below it from sun, for calculateSunShading.
+	std::vector<Uint8> _lightTerrainRoof;
+	/// Light of each dynamic light source alone for each light layer, see addLightCached.
+	std::vector<std::map<LightSourceKey, LightSourceCache>> _lightSourceCache;
+	/// Number of current lighting update, marks sources still in use.
+	Uint32 _lightSourceCacheTick = 0;
+	/// Compiled terrain voxel masks, shared by all tiles with same terrain.
+	std::vector<VoxelTerrainMask> _voxelTerrainMasks;
+	/// Lookup of already compiled terrain voxel masks.
+	std::map<VoxelTerrainKey, Uint32> _voxelTerrainMasksLookup;
+	/// Index of compiled terrain voxel mask for each tile.
+	std::vector<Uint32> _voxelTerrainMaskIndex;
 
 	const RuleInventory *_inventorySlotGround;
 	constexpr static int heightFromCenter[11] = {0,-2,+2,-4,+4,-6,+6,-8,+8,-12,+12};
@@ -118,6 +213,11 @@ private:
 	Tile *_cacheTile;
 	Tile *_cacheTileBelow;
 	Position _cacheTilePos;
+	const VoxelTerrainMask *_cacheTileMask;
+	BattleUnit *_cacheUnit;
+	const Uint16 *_cacheUnitLoft;
+	int _cacheUnitBottom, _cacheUnitTop;
+	bool _cacheUnitValid;
 	const int _maxViewDistance;        // 20 tiles by default
 	const int _maxViewDistanceSq;      // 20 * 20
 	const int _maxVoxelViewDistance;   // maxViewDistance * 16
@@ -125,17 +225,45 @@ private:
 	const int _maxStaticLightDistance;
 	const int _maxDynamicLightDistance;
 	const int _enhancedLighting;
-	Position _eventVisibilitySectorL, _eventVisibilitySectorR, _eventVisibilityObserverPos;
+	/// Buffers of each thread for marking tiles already listed by collectTilesInFOV, kept clear between calls.
+	std::vector<std::vector<bool>> _fovSeen;
+	/// Buffers of each thread for lines traced by collectTilesInFOV.
+	std::vector<std::vector<Position>> _fovTrajectory;
 	std::vector<BattleUnit*> _movingUnitPrev;
 	BattleUnit* _movingUnit = nullptr;
 
+	/// Traces light of one source.
+	template<typename F>
+	void traceLight(MapSubset gs, Position center, int power, LightLayers layer, bool isolated, F write);
 	/// Add light source.
 	void addLight(MapSubset gs, Position center, int power, LightLayers layer);
+	/// Add light source, reusing its light traced before.
+	void addLightCached(MapSubset gs, Position center, int power, LightLayers layer);
+	/// Forgets light of sources that are gone.
+	void cleanLightCache(MapSubset gs, LightLayers layer);
 	/// Calculate blockage amount.
 	int blockage(Tile *tile, const TilePart part, ItemDamageType type, int direction = -1, bool checkingFromOrigin = false);
 
-	bool setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius);
-	inline bool inEventVisibilitySector(const Position &toCheck) const;
+	/// Gets compiled terrain voxel mask of tile.
+	const VoxelTerrainMask &getVoxelTerrainMask(Tile *tile);
+	/// Checks which terrain part occupies a voxel.
+	VoxelType voxelCheckTerrain(Tile *tile, Tile *tileBelow, Position voxel) const;
+	/// Fills cache of unit overlapping cached tile.
+	void voxelCheckCacheUnit();
+
+	bool setupEventVisibilitySector(const Position &observerPos, const Position &eventPos, const int &eventRadius, EventVisibilitySector &sector) const;
+	static inline bool inEventVisibilitySector(const EventVisibilitySector &sector, const Position &toCheck);
+	/// Traces lines of sight from unit to tiles in its view cone.
+	template<typename F>
+	void iterateTilesInFOV(BattleUnit *unit, int direction, int distanceSqrMin, const EventVisibilitySector *sector, std::vector<Position> &trajectory, F visit);
+	/// Marks tile as seen by unit.
+	void revealTileInFOV(BattleUnit *unit, Position posVisited);
+	/// Makes sure each thread has buffers for collectTilesInFOV.
+	void prepareFOVBuffers();
+	/// Collects tiles that become visible to unit without changing them.
+	FOVTilesUpdate collectTilesInFOV(BattleUnit *unit, const Position eventPos, const int eventRadius, bool cleared, std::vector<Position> &visible, int worker);
+	/// Updates visible tiles of unit with collected tiles.
+	void applyTilesInFOV(BattleUnit *unit, FOVTilesUpdate update, const std::vector<Position> &visible);
 
 	/// Calculates sun shading of the whole map.
 	void calculateSunShading(MapSubset gs);
@@ -207,6 +335,10 @@ public:
 	int calculateLineTile(Position origin, Position target, std::vector<Position> &trajectory);
 	/// Calculates a line trajectory in voxel space.
 	VoxelType calculateLineVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, BattleUnit *excludeAllBut = 0, bool onlyVisible = false);
+	/// Calculates many line trajectories in voxel space from the same origin.
+	void calculateLineVoxelBatch(Position origin, VoxelRay *rays, int count, BattleUnit *excludeUnit, BattleUnit *excludeAllBut = 0, bool onlyVisible = false);
+	/// Calculates many line trajectories in voxel space from the same origin, skipping rays after the first one accepted by callback.
+	void calculateLineVoxelBatch(Position origin, VoxelRay *rays, int count, FuncRef<bool(int index)> rayDone, BattleUnit *excludeUnit, BattleUnit *excludeAllBut = 0, bool onlyVisible = false);
 	/// Calculates a parabola trajectory.
 	int calculateParabolaVoxel(Position origin, Position target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, double curvature, const Position delta);
 	/// Gets the origin voxel of a unit's eyesight.
@@ -277,6 +409,8 @@ public:
 	VoxelType voxelCheck(Position voxel, BattleUnit *excludeUnit, bool excludeAllUnits = false, bool onlyVisible = false, BattleUnit *excludeAllBut = 0);
 	/// Flushes cache of voxel check
 	void voxelCheckFlush();
+	/// Marks terrain voxel mask of tile as outdated.
+	void voxelTerrainInvalidate(Tile *tile);
 	/// Blows this tile up.
 	bool detonate(Tile* tile, int power);
 	/// Validates a throwing action.
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "UnitSprite.h"
+#include "ItemSprite.h"
 #include "../Engine/SurfaceSet.h"
 #include "../Mod/RuleItem.h"
 #include "../Mod/Armor.h"
@@ -27,10 +28,36 @@
 #include "../Mod/RuleInventory.h"
 #include "../Mod/Mod.h"
 #include "../Engine/Exception.h"
+#include "../Engine/Logger.h"
 
 namespace OpenXcom
 {
 
+/// Counters of `selectUnitSprite` results reused within one frame.
+ScriptReuseCounter UnitSprite::SelectUnitReuse;
+/// Counters of `selectItemSprite` results reused within one frame.
+ScriptReuseCounter UnitSprite::SelectItemReuse;
+/// Counters of `recolorUnitSprite` results reused within one blit.
+ScriptReuseCounter UnitSprite::RecolorUnitReuse;
+
+/**
+ * Logs how often sprite script results were reused within a frame or a blit,
+ * instead of running the script again, and resets the counters.
+ */
+void UnitSprite::logScriptReuse()
+{
+	auto log = [](const char* name, ScriptReuseCounter& c)
+	{
+		const Uint64 total = c.hits + c.misses;
+		Log(LOG_INFO) << "Script " << name << ": " << c.hits << " of " << total << " results reused (" << (total ? 100 * c.hits / total : 0) << "%).";
+		c = ScriptReuseCounter{};
+	};
+	log("selectUnitSprite", SelectUnitReuse);
+	log("selectItemSprite", SelectItemReuse);
+	log("recolorUnitSprite", RecolorUnitReuse);
+	log("recolorItemSprite", ItemSprite::RecolorItemReuse);
+}
+
 /**
  * Sets up a UnitSprite with the specified size and position.
  * @param width Width in pixels.
@@ -100,11 +127,25 @@ void UnitSprite::selectItem(Part& p, const BattleItem *item, int dir)
 		throw Exception("Frame(s) missing in 'HANDOB.PCK' for item '" + item->getRules()->getType() + "'");
 	}
 
-	int result = ModScript::scriptFunc2<ModScript::SelectItemSprite>(
-		rule,
-		index, dir,
-		item, _save, p.bodyPart, _animationFrame, _shade
-	);
+	// everything else script could read do not change during one frame
+	auto key = std::make_tuple(static_cast<const void*>(item), p.bodyPart, index, dir, _shade);
+	auto it = _selectFrameResults.find(key);
+	int result;
+	if (it != _selectFrameResults.end())
+	{
+		result = it->second;
+		++SelectItemReuse.hits;
+	}
+	else
+	{
+		result = ModScript::scriptFunc2<ModScript::SelectItemSprite>(
+			rule,
+			index, dir,
+			item, _save, p.bodyPart, _animationFrame, _shade
+		);
+		_selectFrameResults.emplace(key, result);
+		++SelectItemReuse.misses;
+	}
 
 	p.src = _itemSurface->getFrame(result);
 }
@@ -124,11 +165,25 @@ void UnitSprite::selectUnit(Part& p, int index, int dir)
 		throw Exception("Frame(s) missing in '" + armor->getSpriteSheet() + "' for armor '" + armor->getType() + "'");
 	}
 
-	int result = ModScript::scriptFunc2<ModScript::SelectUnitSprite>(
-		armor,
-		index, dir,
-		_unit, _save, p.bodyPart, _animationFrame, _shade
-	);
+	// everything else script could read do not change during one frame
+	auto key = std::make_tuple(static_cast<const void*>(_unit), p.bodyPart, index, dir, _shade);
+	auto it = _selectFrameResults.find(key);
+	int result;
+	if (it != _selectFrameResults.end())
+	{
+		result = it->second;
+		++SelectUnitReuse.hits;
+	}
+	else
+	{
+		result = ModScript::scriptFunc2<ModScript::SelectUnitSprite>(
+			armor,
+			index, dir,
+			_unit, _save, p.bodyPart, _animationFrame, _shade
+		);
+		_selectFrameResults.emplace(key, result);
+		++SelectUnitReuse.misses;
+	}
 
 	p.src = _unitSurface->getFrame(result);
 }
@@ -148,7 +203,7 @@ void UnitSprite::blitItem(Part& item)
 
 	_dest->lock();
 
-	work.executeBlit(item.src, _dest,  _x + item.offX, _y + item.offY, _shade, _mask);
+	work.executeBlit(item.src, _dest,  _x + item.offX, _y + item.offY, _shade, _mask, &ItemSprite::RecolorItemReuse);
 
 	_dest->unlock();
 }
@@ -168,7 +223,7 @@ void UnitSprite::blitBody(Part& body)
 
 	_dest->lock();
 
-	work.executeBlit(body.src, _dest,  _x + body.offX, _y + body.offY, _shade, _mask);
+	work.executeBlit(body.src, _dest,  _x + body.offX, _y + body.offY, _shade, _mask, &RecolorUnitReuse);
 
 	_dest->unlock();
 }
@@ -17,6 +17,8 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <map>
+#include <tuple>
 #include "../Engine/Surface.h"
 #include "../Engine/Script.h"
 
@@ -59,6 +61,8 @@ private:
 	bool _helmet;
 	int _x, _y, _shade, _burn;
 	GraphSubset _mask;
+	/// Results of select scripts in this frame, keyed by unit or item, body part, sprite index, direction and shade.
+	std::map<std::tuple<const void*, int, int, int, int>, int> _selectFrameResults;
 
 	/// Drawing routine for XCom soldiers in overalls, sectoids (routine 0),
 	/// mutons (routine 10),
@@ -107,6 +111,15 @@ private:
 	/// Blit body sprite.
 	void blitBody(Part& body);
 public:
+	/// Counters of `selectUnitSprite` results reused within one frame.
+	static ScriptReuseCounter SelectUnitReuse;
+	/// Counters of `selectItemSprite` results reused within one frame.
+	static ScriptReuseCounter SelectItemReuse;
+	/// Counters of `recolorUnitSprite` results reused within one blit.
+	static ScriptReuseCounter RecolorUnitReuse;
+	/// Logs and resets counters of script results reused within a frame or a blit.
+	static void logScriptReuse();
+
 	/// Creates a new UnitSprite at the specified position and size.
 	UnitSprite(Surface* dest, const Mod* mod, const SavedBattleGame* save, int frame, bool helmet);
 	/// Cleans up the UnitSprite.
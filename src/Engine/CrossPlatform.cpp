@@ -26,6 +26,7 @@
 #include <fstream>
 #include <string>
 #include <list>
+#include <mutex>
 #include <stdint.h>
 #include <time.h>
 #include <signal.h>
@@ -961,6 +962,44 @@ time_t getDateModified(const std::string &path)
 #endif
 }
 
+/**
+ * Gets the size and the precise modified date of a file,
+ * for noticing changes made within the same second.
+ * @param path Full path to file.
+ * @param size Returned size in bytes.
+ * @param modified Returned modified date in nanoseconds, as precise as the system allows.
+ * @return True if the file could be read.
+ */
+bool getFileStamp(const std::string &path, uint64_t &size, uint64_t &modified)
+{
+#ifdef _WIN32
+	auto pathW = pathToWindows(path);
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExW(pathW.c_str(), GetFileExInfoStandard, &data))
+	{
+		return false;
+	}
+	size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	modified = (((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime) * 100;
+	return true;
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		return false;
+	}
+	size = info.st_size;
+#if defined(__APPLE__)
+	modified = (uint64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+	modified = (uint64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#else
+	modified = (uint64_t)info.st_mtime * 1000000000;
+#endif
+	return true;
+#endif
+}
+
 /**
  * Converts a date/time into a human-readable string
  * using the ISO 8601 standard.
@@ -1090,6 +1129,33 @@ bool writeFile(const std::string& filename, const std::vector<unsigned char>& da
 	return true;
 }
 
+/**
+ * Writes a file in parts, without building whole content in memory first.
+ * @param filename - where to writeFile
+ * @param binary - write bytes as they are, without text mode line ending conversion
+ * @param writer - called once with function that appends data to the file, returns false on failure
+ * @return if we did write it.
+ */
+bool writeFile(const std::string& filename, bool binary, FuncRef<bool(FuncRef<bool(const void *data, size_t size)> write)> writer) {
+	// Even SDL1 file IO accepts UTF-8 file names on windows.
+	SDL_RWops *rwops = SDL_RWFromFile(filename.c_str(), binary ? "wb" : "w");
+	if (!rwops) {
+		Log(LOG_ERROR) << "Failed to write " << filename << ": " << SDL_GetError();
+		return false;
+	}
+	bool failed = false;
+	auto write = [&](const void *data, size_t size) {
+		if (!failed && size > 0 && 1 != SDL_RWwrite(rwops, data, size, 1)) {
+			Log(LOG_ERROR) << "Failed to write " << filename << ": " << SDL_GetError();
+			failed = true;
+		}
+		return !failed;
+	};
+	const bool done = writer(write);
+	SDL_RWclose(rwops);
+	return done && !failed;
+}
+
 /**
  * Fully reads a file and returns a stream
  * @param filename - what to readFile
@@ -1616,6 +1682,9 @@ void setLogFileName(const std::string& name) {
 	logFileName = name;
 }
 void log(int level, const std::ostringstream& baremsgstream) {
+	// messages can come from worker threads too
+	static std::mutex logMutex;
+	std::lock_guard<std::mutex> lock(logMutex);
 	std::ostringstream msgstream;
 	msgstream << "[" << CrossPlatform::now() << "]" << "\t"
 			  << "[" << Logger::toString(level) << "]" << "\t"
@@ -24,6 +24,8 @@
 #include <array>
 #include <memory>
 #include <utility>
+#include <cstdint>
+#include "Functions.h"
 
 namespace OpenXcom
 {
@@ -230,6 +232,8 @@ namespace CrossPlatform
 	bool isQuitShortcut(const SDL_Event &ev);
 	/// Gets the modified date of a file.
 	time_t getDateModified(const std::string &path);
+	/// Gets the size and the precise modified date of a file.
+	bool getFileStamp(const std::string &path, uint64_t &size, uint64_t &modified);
 	/// Converts a timestamp to a string.
 	std::pair<std::string, std::string> timeToString(time_t time);
 	/// Move/rename a file between paths.
@@ -239,6 +243,8 @@ namespace CrossPlatform
 	/// Writes out a file
 	bool writeFile(const std::string& filename, const std::string& data);
 	bool writeFile(const std::string& filename, const std::vector<unsigned char>& data);
+	/// Writes out a file in parts
+	bool writeFile(const std::string& filename, bool binary, FuncRef<bool(FuncRef<bool(const void *data, size_t size)> write)> writer);
 	/// Reads in a file
 	std::unique_ptr<std::istream> readFile(const std::string& filename);
 	/// Reads in a file
@@ -41,6 +41,7 @@
 #include <istream>
 #include <unordered_map>
 #include <unordered_set>
+#include <mutex>
 
 #include "FileMap.h"
 #include "Unicode.h"
@@ -264,15 +265,14 @@ SDL_RWops *FileRecord::getRWopsReadAll() const
 
 std::unique_ptr<std::istream> FileRecord::getIStream() const
 {
-	if (zip != NULL) {
-		return std::unique_ptr<std::istream>(new StreamData(getUnzippedData()));
-	} else {
-		return CrossPlatform::readFile(fullpath);
-	}
+	return std::unique_ptr<std::istream>(new StreamData(getRawData()));
 }
 
 RawData FileRecord::getUnzippedData() const
 {
+	// zip archives are read through one shared file handle, rulesets are unpacked from worker threads
+	static std::mutex zipMutex;
+	std::lock_guard<std::mutex> lock(zipMutex);
 	size_t size;
 	void* data = mz_zip_reader_extract_to_heap((mz_zip_archive*)zip, findex, &size, 0);
 	if (data == NULL)
@@ -285,12 +285,20 @@ RawData FileRecord::getUnzippedData() const
 	return RawData(data, size, mz_free);
 }
 
+RawData FileRecord::getRawData() const
+{
+	if (zip != NULL) {
+		return getUnzippedData();
+	} else {
+		return CrossPlatform::readFileRaw(fullpath);
+	}
+}
+
 YAML::YamlRootNodeReader FileRecord::getYAML() const
 {
 	try
 	{
-		RawData data = zip != NULL ? getUnzippedData() : CrossPlatform::readFileRaw(fullpath);
-		return YAML::YamlRootNodeReader(data, fullpath);
+		return YAML::YamlRootNodeReader(getRawData(), fullpath);
 	}
 	catch(...)
 	{
@@ -53,6 +53,8 @@ namespace FileMap
 
 		std::unique_ptr<std::istream> getIStream() const;
 		RawData getUnzippedData() const;
+		/// Read the whole file to memory, from zip or from disk.
+		RawData getRawData() const;
 		YAML::YamlRootNodeReader getYAML() const;
 		std::vector<YAML::YamlNodeReader> getAllYAML() const;
 	};
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <cmath>
 #include <sstream>
+#include <typeinfo>
 #include <SDL_mixer.h>
 #include "State.h"
 #include "Screen.h"
@@ -28,6 +29,7 @@
 #include "Music.h"
 #include "Language.h"
 #include "Logger.h"
+#include "Profiler.h"
 #include "../Interface/Cursor.h"
 #include "../Interface/FpsCounter.h"
 #include "../Mod/Mod.h"
@@ -111,6 +113,7 @@ Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _save(0
  */
 Game::~Game()
 {
+	SavedGame::finishBackgroundSave();
 	Sound::stop();
 	Music::stop();
 
@@ -179,6 +182,7 @@ void Game::run()
 		}
 
 		// Process events
+		Uint64 eventsStart = Profiler::isEnabled() ? Profiler::now() : 0;
 		while (SDL_PollEvent(&_event))
 		{
 			if (CrossPlatform::isQuitShortcut(_event))
@@ -273,7 +277,11 @@ void Game::run()
 					FALLTHROUGH;
 				default:
 					Action action = Action(&_event, _screen->getXScale(), _screen->getYScale(), _screen->getCursorTopBlackBand(), _screen->getCursorLeftBlackBand());
-					_screen->handle(&action);
+					if (_screen->handle(&action))
+					{
+						// debug shortcut, keep it from triggering the same key in the current state
+						break;
+					}
 					_cursor->handle(&action);
 					_fpsCounter->handle(&action);
 					if (action.getDetails()->type == SDL_KEYDOWN)
@@ -326,12 +334,19 @@ void Game::run()
 				break;
 			}
 		}
+		if (eventsStart)
+		{
+			Profiler::addEvent("events", eventsStart, Profiler::now());
+		}
 
 		// Process rendering
 		if (runningState != PAUSED)
 		{
 			// Process logic
-			_states.back()->think();
+			{
+				ProfilerScope scope("think");
+				_states.back()->think();
+			}
 			_fpsCounter->think();
 			if (Options::FPS > 0 && !(Options::useOpenGL && Options::vSyncForOpenGL))
 			{
@@ -358,13 +373,22 @@ void Game::run()
 				}
 				while (i != _states.begin() && !(*i)->isScreen());
 
-				for (; i != _states.end(); ++i)
 				{
-					(*i)->blit();
+					ProfilerScope scope("blit");
+					for (; i != _states.end(); ++i)
+					{
+						ProfilerScope stateScope(typeid(**i).name());
+						(*i)->blit();
+					}
 				}
 				_fpsCounter->blit(_screen->getSurface());
+				Profiler::draw(_screen->getSurface(), _cursor->getColor());
 				_cursor->blit(_screen->getSurface());
-				_screen->flip();
+				{
+					ProfilerScope scope("flip");
+					_screen->flip();
+				}
+				Profiler::endFrame();
 			}
 		}
 
@@ -367,6 +367,14 @@ void createOptionsOXCE()
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceThumbButtons", &oxceThumbButtons, true));
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceThrottleMouseMoveEvent", &oxceThrottleMouseMoveEvent, 0));
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceDisableThinkingProgressBar", &oxceDisableThinkingProgressBar, false));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceWorkerThreads", &oxceWorkerThreads, 1));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceHierarchicalPathfinding", &oxceHierarchicalPathfinding, false));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxcePathfindingCostCache", &oxcePathfindingCostCache, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceLightSourceCache", &oxceLightSourceCache, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceDirtyFrameUpdates", &oxceDirtyFrameUpdates, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceShadedTerrainMemory", &oxceShadedTerrainMemory, 64));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceBackgroundAutosave", &oxceBackgroundAutosave, true));
+	_info.push_back(OptionInfo(OPTION_OXCE, "oxceCompressedSaves", &oxceCompressedSaves, false));
 
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceEmbeddedOnly", &oxceEmbeddedOnly, true));
 	_info.push_back(OptionInfo(OPTION_OXCE, "oxceListVFSContents", &oxceListVFSContents, false));
@@ -116,6 +116,18 @@ OPT bool oxceFirstPersonViewFisheyeProjection;
 OPT bool oxceThumbButtons;
 OPT int oxceThrottleMouseMoveEvent;
 OPT bool oxceDisableThinkingProgressBar;
+/**
+ * Number of threads used for parallel jobs (FOV, scaling, etc.).
+ * 1 = everything on the main thread, 0 = one per CPU core.
+ */
+OPT int oxceWorkerThreads;
+OPT bool oxceHierarchicalPathfinding;
+OPT bool oxcePathfindingCostCache;
+OPT bool oxceLightSourceCache;
+OPT bool oxceDirtyFrameUpdates;
+OPT int oxceShadedTerrainMemory;
+OPT bool oxceBackgroundAutosave;
+OPT bool oxceCompressedSaves;
 
 OPT bool oxceEmbeddedOnly;
 OPT bool oxceListVFSContents;
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+#include "CrossPlatform.h"
+#include "Logger.h"
+#include "Options.h"
+#include "Palette.h"
+#include <SDL_gfxPrimitives.h>
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Measured scope.
+struct ProfilerEvent
+{
+	const char *name;
+	Uint64 start, end;
+};
+
+/// Sum of all calls of one scope.
+struct ProfilerStat
+{
+	Uint64 time = 0;
+	int calls = 0;
+};
+
+/// Limit of trace size, around 24MB of memory.
+const size_t MaxEvents = 1 << 20;
+/// Overlay lines, beside the header.
+const int OverlayLines = 12;
+
+/// Compares names of scopes, same literal can have different addresses in different files.
+struct NameLess
+{
+	bool operator()(const char *a, const char *b) const
+	{
+		return strcmp(a, b) < 0;
+	}
+};
+
+std::atomic<std::thread::id> mainThread;
+std::vector<ProfilerEvent> events;
+std::map<const char*, ProfilerStat, NameLess> stats;
+std::vector<std::pair<const char*, ProfilerStat>> shownStats;
+Uint64 secondStart = 0;
+int frames = 0;
+int shownFrames = 0;
+
+/**
+ * Gets name of scope without namespace, states are measured
+ * using their type names that compilers decorate differently.
+ */
+std::string readableName(const char *name)
+{
+	std::string s = name;
+	size_t ns = s.find("OpenXcom");
+	if (ns == std::string::npos)
+	{
+		return s;
+	}
+	s = s.substr(ns + 8);
+	s.erase(0, s.find_first_not_of(":0123456789"));
+	if (!s.empty() && s.back() == 'E')
+	{
+		s.pop_back();
+	}
+	return s;
+}
+
+/**
+ * Writes name of scope as json string.
+ */
+void writeName(std::ostringstream &ss, const char *name)
+{
+	const std::string readable = readableName(name);
+	ss << '"';
+	for (const char *c = readable.c_str(); *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			ss << '\\';
+		}
+		ss << *c;
+	}
+	ss << '"';
+}
+
+}//namespace
+
+std::atomic<bool> Profiler::_enabled{ false };
+
+/**
+ * Turns measuring on or off. Turning it on clears
+ * the old trace and timings.
+ * @param enabled New state.
+ */
+void Profiler::setEnabled(bool enabled)
+{
+	if (enabled && !_enabled)
+	{
+		mainThread = std::this_thread::get_id();
+		events.clear();
+		stats.clear();
+		shownStats.clear();
+		secondStart = now();
+		frames = 0;
+		shownFrames = 0;
+	}
+	_enabled = enabled;
+	Log(LOG_INFO) << "Profiler " << (enabled ? "enabled." : "disabled.");
+}
+
+/**
+ * Gets the time from the start of the program, never zero.
+ * @return Time in microseconds.
+ */
+Uint64 Profiler::now()
+{
+	static const auto begin = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count() + 1;
+}
+
+/**
+ * Adds a finished scope to the timings and the trace.
+ * Scopes of other threads than the main one are ignored.
+ * @param name Name of the scope.
+ * @param start Time when the scope started.
+ * @param end Time when the scope ended.
+ */
+void Profiler::addEvent(const char *name, Uint64 start, Uint64 end)
+{
+	if (!_enabled || std::this_thread::get_id() != mainThread.load())
+	{
+		return;
+	}
+	ProfilerStat &stat = stats[name];
+	stat.time += end - start;
+	stat.calls += 1;
+	if (events.size() < MaxEvents)
+	{
+		events.push_back(ProfilerEvent{ name, start, end });
+	}
+}
+
+/**
+ * Ends current frame. Once per second the summed timings
+ * replace the ones shown in the overlay.
+ */
+void Profiler::endFrame()
+{
+	if (!_enabled)
+	{
+		return;
+	}
+	++frames;
+	Uint64 time = now();
+	if (time - secondStart >= 1000000)
+	{
+		shownStats.assign(stats.begin(), stats.end());
+		std::sort(shownStats.begin(), shownStats.end(), [](const std::pair<const char*, ProfilerStat> &a, const std::pair<const char*, ProfilerStat> &b) { return a.second.time > b.second.time; });
+		shownFrames = frames;
+		stats.clear();
+		frames = 0;
+		secondStart = time;
+	}
+}
+
+/**
+ * Draws timings of the last second, as milliseconds and calls per frame.
+ * Nested scopes are part of the time of their parents.
+ * @param surface Screen surface to draw on.
+ * @param color Palette index of the text, white is used on surfaces without a palette.
+ */
+void Profiler::draw(SDL_Surface *surface, Uint8 color)
+{
+	if (!_enabled)
+	{
+		return;
+	}
+	const int lineHeight = 9;
+	const int lines = std::min((int)shownStats.size(), OverlayLines);
+	const Uint32 rgba = surface->format->palette ? Palette::getRGBA(surface->format->palette->colors, color) : 0xFFFFFFFF;
+	SDL_Rect background = { 0, 8, 26 * 8 + 2, (Uint16)((lines + 1) * lineHeight + 2) };
+	SDL_FillRect(surface, &background, 0);
+
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(2);
+	ss << "PROFILE " << shownFrames << " FPS";
+	stringColor(surface, 1, 9, ss.str().c_str(), rgba);
+	for (int i = 0; i < lines; ++i)
+	{
+		const ProfilerStat &stat = shownStats[i].second;
+		const int frameCount = std::max(shownFrames, 1);
+		ss.str("");
+		ss << std::left << std::setw(12) << readableName(shownStats[i].first).substr(0, 11);
+		ss << std::right << std::setw(7) << stat.time / 1000.0 / frameCount << std::setw(7) << (stat.calls + frameCount - 1) / frameCount;
+		stringColor(surface, 1, 9 + (i + 1) * lineHeight, ss.str().c_str(), rgba);
+	}
+}
+
+/**
+ * Saves all scopes measured since turning on the profiler or the last save,
+ * as a json trace for chrome://tracing or similar tools.
+ * @return Name of the file, empty if nothing was saved.
+ */
+std::string Profiler::saveTrace()
+{
+	if (events.empty())
+	{
+		return "";
+	}
+
+	std::ostringstream file;
+	int i = 0;
+	do
+	{
+		file.str("");
+		file << Options::getMasterUserFolder() << "trace" << std::setfill('0') << std::setw(3) << i << ".json";
+		i++;
+	}
+	while (CrossPlatform::fileExists(file.str()));
+
+	std::ostringstream ss;
+	ss << "{\"traceEvents\":[\n";
+	for (size_t e = 0; e < events.size(); ++e)
+	{
+		const ProfilerEvent &event = events[e];
+		ss << "{\"name\":";
+		writeName(ss, event.name);
+		ss << ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << event.start << ",\"dur\":" << event.end - event.start << "}";
+		ss << (e + 1 < events.size() ? ",\n" : "\n");
+	}
+	ss << "],\"displayTimeUnit\":\"ms\"}\n";
+
+	if (!CrossPlatform::writeFile(file.str(), ss.str()))
+	{
+		Log(LOG_ERROR) << "Failed to save profiler trace to " << file.str();
+		return "";
+	}
+	Log(LOG_INFO) << "Profiler trace with " << events.size() << " scopes saved to " << file.str();
+	events.clear();
+	return file.str();
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <string>
+#include <SDL.h>
+
+namespace OpenXcom
+{
+
+/**
+ * Collects how long named parts of the game loop take.
+ * Timings of the last second are shown in an overlay and every
+ * measured scope can be saved as a trace for chrome://tracing.
+ * Only scopes on the main thread are measured, work of the thread
+ * pool is counted in the scope that waits for it.
+ */
+class Profiler
+{
+	static std::atomic<bool> _enabled;
+public:
+	/// Turns measuring on or off, turning it on starts a new trace.
+	static void setEnabled(bool enabled);
+	/// Is measuring turned on?
+	static bool isEnabled() { return _enabled; }
+	/// Gets current time in microseconds.
+	static Uint64 now();
+	/// Adds a finished scope.
+	static void addEvent(const char *name, Uint64 start, Uint64 end);
+	/// Ends a frame, updates overlay timings once per second.
+	static void endFrame();
+	/// Draws timings of the last second.
+	static void draw(SDL_Surface *surface, Uint8 color);
+	/// Saves measured scopes in the user folder.
+	static std::string saveTrace();
+};
+
+/**
+ * Measures the time from its creation to its destruction,
+ * put it at the start of the block that needs measuring.
+ */
+class ProfilerScope
+{
+	const char *_name;
+	Uint64 _start;
+public:
+	/// Starts measuring, name needs to outlive the profiler (use string literals).
+	ProfilerScope(const char *name) : _name(name), _start(Profiler::isEnabled() ? Profiler::now() : 0)
+	{
+
+	}
+	/// Ends measuring.
+	~ProfilerScope()
+	{
+		if (_start)
+		{
+			Profiler::addEvent(_name, _start, Profiler::now());
+		}
+	}
+	ProfilerScope(const ProfilerScope&) = delete;
+	ProfilerScope& operator=(const ProfilerScope&) = delete;
+};
+
+}
@@ -33,6 +33,7 @@
 #include "FileMap.h"
 #include "Zoom.h"
 #include "Timer.h"
+#include "Profiler.h"
 #include <SDL.h>
 #include <algorithm>
 
@@ -112,7 +113,7 @@ void Screen::makeVideoFlags()
  * Initializes a new display screen for the game to render contents to.
  * The screen is set up based on the current options.
  */
-Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _flickerFix(false)
+Screen::Screen() : _baseWidth(ORIGINAL_WIDTH), _baseHeight(ORIGINAL_HEIGHT), _scaleX(1.0), _scaleY(1.0), _flags(0), _numColors(0), _firstColor(0), _pushPalette(false), _paletteDirty(false), _flickerFix(false)
 {
 	_flickerFix = Options::oxceEnablePaletteFlickerFix;
 
@@ -143,8 +144,9 @@ SDL_Surface *Screen::getSurface()
 /**
  * Handles screen key shortcuts.
  * @param action Pointer to an action.
+ * @return True if the action was a debug shortcut that other handlers must not see.
  */
-void Screen::handle(Action *action)
+bool Screen::handle(Action *action)
 {
 	if (Options::debug)
 	{
@@ -157,6 +159,28 @@ void Screen::handle(Action *action)
 				default: Timer::gameSlowSpeed = 1; break;
 			}
 		}
+		// "alt-F9" - scaler and blit benchmark
+		else if (action->getDetails()->type == SDL_KEYDOWN && action->getDetails()->key.keysym.sym == SDLK_F9 && (SDL_GetModState() & KMOD_ALT) != 0)
+		{
+			Zoom::benchmark();
+			Surface::benchmarkBlit();
+			// F9 is quick load by default
+			return true;
+		}
+		// "alt-F10" - profiler overlay
+		else if (action->getDetails()->type == SDL_KEYDOWN && action->getDetails()->key.keysym.sym == SDLK_F10 && (SDL_GetModState() & KMOD_ALT) != 0)
+		{
+			Profiler::setEnabled(!Profiler::isEnabled());
+			// F10 is the voxel view in the battlescape
+			return true;
+		}
+		// "alt-F11" - save profiler trace
+		else if (action->getDetails()->type == SDL_KEYDOWN && action->getDetails()->key.keysym.sym == SDLK_F11 && (SDL_GetModState() & KMOD_ALT) != 0)
+		{
+			Profiler::saveTrace();
+			// F11 is the voxel map dump in battlescape debug mode
+			return true;
+		}
 	}
 
 	if (action->getDetails()->type == SDL_KEYDOWN && action->getDetails()->key.keysym.sym == SDLK_RETURN && (SDL_GetModState() & KMOD_ALT) != 0)
@@ -176,8 +200,8 @@ void Screen::handle(Action *action)
 		}
 		while (CrossPlatform::fileExists(ss.str()));
 		screenshot(ss.str());
-		return;
 	}
+	return false;
 }
 
 
@@ -201,13 +225,56 @@ void Screen::flip()
 		_pushPalette = false;
 	}
 
+	// find rows that changed since the last frame
+	const bool dirtyFrames = useDirtyFrames();
+	// palette changes recolor the whole frame, even if indexes stay same
+	const bool fullFrame = !dirtyFrames || _paletteDirty || _lastFrame.empty();
+	int dirtyBegin = 0, dirtyEnd = _surface->h;
+	if (dirtyFrames)
+	{
+		const Uint8 *pixels = (const Uint8*)_surface->pixels;
+		const size_t pitch = _surface->pitch;
+		if (fullFrame)
+		{
+			_lastFrame.assign(pixels, pixels + pitch * _surface->h);
+			Surface::CleanSdlSurface(_screen);
+		}
+		else
+		{
+			while (dirtyBegin < dirtyEnd && memcmp(&_lastFrame[pitch * dirtyBegin], pixels + pitch * dirtyBegin, pitch) == 0)
+			{
+				++dirtyBegin;
+			}
+			if (dirtyBegin == dirtyEnd)
+			{
+				// nothing to show, the screen already has this frame
+				return;
+			}
+			while (memcmp(&_lastFrame[pitch * (dirtyEnd - 1)], pixels + pitch * (dirtyEnd - 1), pitch) == 0)
+			{
+				--dirtyEnd;
+			}
+			std::copy(pixels + pitch * dirtyBegin, pixels + pitch * dirtyEnd, &_lastFrame[pitch * dirtyBegin]);
+			// filters look at neighbouring rows, xBRZ needs two
+			dirtyBegin = std::max(dirtyBegin - 2, 0);
+			dirtyEnd = std::min(dirtyEnd + 2, _surface->h);
+		}
+	}
+	else
+	{
+		_lastFrame.clear();
+	}
+
 	if (getWidth() != _baseWidth || getHeight() != _baseHeight || useOpenGL())
 	{
-		Zoom::flipWithZoom(_surface.get(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput);
+		ProfilerScope scope("scale");
+		Zoom::flipWithZoom(_surface.get(), _screen, _topBlackBand, _bottomBlackBand, _leftBlackBand, _rightBlackBand, &glOutput, dirtyBegin, dirtyEnd);
 	}
 	else
 	{
-		SDL_BlitSurface(_surface.get(), 0, _screen, 0);
+		SDL_Rect srcrect = {0, (Sint16)dirtyBegin, (Uint16)_surface->w, (Uint16)(dirtyEnd - dirtyBegin)};
+		SDL_Rect dstrect = srcrect;
+		SDL_BlitSurface(_surface.get(), &srcrect, _screen, &dstrect);
 	}
 
 	// perform any requested palette update
@@ -221,12 +288,22 @@ void Screen::flip()
 		_pushPalette = false;
 	}
 
-
-
-	if (SDL_Flip(_screen) == -1)
+	if (fullFrame)
+	{
+		if (SDL_Flip(_screen) == -1)
+		{
+			throw Exception(SDL_GetError());
+		}
+	}
+	else
 	{
-		throw Exception(SDL_GetError());
+		// map the changed rows to the scaled picture, rounding outwards
+		const int dstHeight = _screen->h - _topBlackBand - _bottomBlackBand;
+		const int y1 = _topBlackBand + dirtyBegin * dstHeight / _surface->h;
+		const int y2 = _topBlackBand + (dirtyEnd * dstHeight + _surface->h - 1) / _surface->h;
+		SDL_UpdateRect(_screen, 0, y1, _screen->w, y2 - y1);
 	}
+	_paletteDirty = false;
 }
 
 /**
@@ -263,6 +340,7 @@ void Screen::setPalette(const SDL_Color* colors, int firstcolor, int ncolors, bo
 	}
 
 	SDL_SetColors(_surface.get(), const_cast<SDL_Color *>(colors), firstcolor, ncolors);
+	_paletteDirty = true;
 
 	// defer actual update of screen until SDL_Flip()
 	if (immediately && _screen->format->BitsPerPixel == 8 && SDL_SetColors(_screen, const_cast<SDL_Color *>(colors), firstcolor, ncolors) == 0)
@@ -329,6 +407,7 @@ void Screen::resetDisplay(bool resetVideo, bool noShaders)
 	int width = Options::displayWidth;
 	int height = Options::displayHeight;
 	makeVideoFlags();
+	_lastFrame.clear(); // next frame is drawn whole
 
 	if (!_surface || (_surface->format->BitsPerPixel != _bpp ||
 		_surface->w != _baseWidth ||
@@ -627,6 +706,18 @@ bool Screen::use32bitScaler()
 	return false;
 }
 
+/**
+ * Check if frames can be put on screen partially, with only the rows
+ * that changed since the last frame being scaled and updated.
+ * Needs a single buffered software display, OpenGL and page flipping
+ * always redraw the whole frame.
+ * @return if it is enabled.
+ */
+bool Screen::useDirtyFrames() const
+{
+	return Options::oxceDirtyFrameUpdates && !useOpenGL() && _screen && (_screen->flags & SDL_DOUBLEBUF) != SDL_DOUBLEBUF;
+}
+
 /**
  * Check if OpenGL is enabled.
  * @return if it is enabled.
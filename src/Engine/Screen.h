@@ -19,6 +19,7 @@
  */
 #include <SDL.h>
 #include <string>
+#include <vector>
 #include "OpenGL.h"
 #include "Surface.h"
 
@@ -48,12 +49,17 @@ private:
 	SDL_Color deferredPalette[256];
 	int _numColors, _firstColor;
 	bool _pushPalette;
+	/// Palette changed since last flip, whole frame need be redrawn.
+	bool _paletteDirty;
 	bool _flickerFix;
 	OpenGL glOutput;
 	Surface::UniqueBufferPtr _buffer;
 	Surface::UniqueSurfacePtr _surface;
+	std::vector<Uint8> _lastFrame;
 	/// Sets the _flags and _bpp variables based on game options; needed in more than one place now
 	void makeVideoFlags();
+	/// Checks if only the changed part of the frame can be put on screen.
+	bool useDirtyFrames() const;
 public:
 	static const int ORIGINAL_WIDTH;
 	static const int ORIGINAL_HEIGHT;
@@ -69,7 +75,7 @@ public:
 	/// Gets the internal buffer.
 	SDL_Surface *getSurface();
 	/// Handles keyboard events.
-	void handle(Action *action);
+	bool handle(Action *action);
 	/// Renders the screen onto the game window.
 	void flip();
 	/// Clears the screen.
@@ -37,6 +37,7 @@
 #include "Exception.h"
 #include "../fallthrough.h"
 #include "Collections.h"
+#include "Profiler.h"
 
 namespace OpenXcom
 {
@@ -502,19 +503,23 @@ static inline void scriptExe(ScriptWorkerBase& data, const Uint8* proc)
 //						Script class
 ////////////////////////////////////////////////////////////
 
-void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int y, int shade)
+void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int y, int shade, ScriptReuseCounter* counter)
 {
-	executeBlit(src, dest, x, y, shade, GraphSubset{ dest->getWidth(), dest->getHeight() } );
+	executeBlit(src, dest, x, y, shade, GraphSubset{ dest->getWidth(), dest->getHeight() }, counter);
 }
 /**
  * Blitting one surface to another using script.
+ * Script result depends only on source and destination pixel, everything else
+ * is same for whole blit, so results are reused for pixels that repeat.
  * @param src source surface.
  * @param dest destination surface.
  * @param x x offset of source surface.
  * @param y y offset of source surface.
+ * @param counter optional counter of reused results.
  */
-void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int y, int shade, GraphSubset mask)
+void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int y, int shade, GraphSubset mask, ScriptReuseCounter* counter)
 {
+	ProfilerScope scope("script blit");
 	ShaderMove<const Uint8> srcShader(src, x, y);
 	ShaderMove<Uint8> destShader(dest, 0, 0);
 
@@ -522,60 +527,70 @@ void ScriptWorkerBlit::executeBlit(const Surface* src, Surface* dest, int x, int
 
 	if (_proc)
 	{
-		if (_events)
+		auto run = [&](Uint8 srcStuff, Uint8 destStuff)
 		{
-			ShaderDrawFunc(
-				[&](Uint8& destStuff, const Uint8& srcStuff)
+			ScriptWorkerBlit::Output arg = { srcStuff, destStuff };
+			set(arg);
+			if (_events)
+			{
+				auto ptr = _events;
+				while (*ptr)
 				{
-					if (srcStuff)
-					{
-						ScriptWorkerBlit::Output arg = { srcStuff, destStuff };
-						set(arg);
-						auto ptr = _events;
-						while (*ptr)
-						{
-							reset(arg);
-							scriptExe(*this, ptr->data());
-							++ptr;
-						}
-						++ptr;
+					reset(arg);
+					scriptExe(*this, ptr->data());
+					++ptr;
+				}
+				++ptr;
 
-						reset(arg);
-						scriptExe(*this, _proc);
+				reset(arg);
+				scriptExe(*this, _proc);
 
-						while (*ptr)
-						{
-							reset(arg);
-							scriptExe(*this, ptr->data());
-							++ptr;
-						}
-						++ptr;
+				while (*ptr)
+				{
+					reset(arg);
+					scriptExe(*this, ptr->data());
+					++ptr;
+				}
+				++ptr;
+			}
+			else
+			{
+				scriptExe(*this, _proc);
+			}
+			get(arg);
+			return arg.getFirst();
+		};
 
-						get(arg);
-						if (arg.getFirst()) destStuff = arg.getFirst();
-					}
-				},
-				destShader,
-				srcShader
-			);
-		}
-		else
-		{
-			ShaderDrawFunc(
-				[&](Uint8& destStuff, const Uint8& srcStuff)
+		// entry is `1 << 25 | src << 17 | dest << 9 | changed << 8 | result`, zero is empty
+		Uint32 cache[256] = { };
+		Uint64 hits = 0, misses = 0;
+		ShaderDrawFunc(
+			[&](Uint8& destStuff, const Uint8& srcStuff)
+			{
+				if (srcStuff)
 				{
-					if (srcStuff)
+					const Uint32 key = (1u << 16) | (srcStuff << 8) | destStuff;
+					Uint32& entry = cache[(srcStuff * 7 + destStuff) & 0xFF];
+					if ((entry >> 9) == key)
 					{
-						ScriptWorkerBlit::Output arg = { srcStuff, destStuff };
-						set(arg);
-						scriptExe(*this, _proc);
-						get(arg);
-						if (arg.getFirst()) destStuff = arg.getFirst();
+						++hits;
 					}
-				},
-				destShader,
-				srcShader
-			);
+					else
+					{
+						const int result = run(srcStuff, destStuff);
+						entry = (key << 9) | ((result ? 1u : 0u) << 8) | (Uint8)result;
+						++misses;
+					}
+					if (entry & 0x100) destStuff = (Uint8)entry;
+				}
+			},
+			destShader,
+			srcShader
+		);
+		if (counter)
+		{
+			counter->hits += hits;
+			counter->misses += misses;
 		}
 	}
 	else
@@ -592,6 +607,7 @@ void ScriptWorkerBase::executeBase(const Uint8* proc)
 {
 	if (proc)
 	{
+		ProfilerScope scope("script");
 		scriptExe(*this, proc);
 	}
 }
@@ -814,6 +814,15 @@ public:
 	}
 };
 
+/**
+ * Counts how often script results were reused instead of running script again, within one frame or one blit.
+ */
+struct ScriptReuseCounter
+{
+	Uint64 hits = 0;
+	Uint64 misses = 0;
+};
+
 /**
  * Strong typed blit script executor.
  */
@@ -862,9 +871,9 @@ public:
 	}
 
 	/// Programmable blitting using script.
-	void executeBlit(const Surface* src, Surface* dest, int x, int y, int shade);
+	void executeBlit(const Surface* src, Surface* dest, int x, int y, int shade, ScriptReuseCounter* counter = nullptr);
 	/// Programmable blitting using script.
-	void executeBlit(const Surface* src, Surface* dest, int x, int y, int shade, GraphSubset mask);
+	void executeBlit(const Surface* src, Surface* dest, int x, int y, int shade, GraphSubset mask, ScriptReuseCounter* counter = nullptr);
 
 	/// Clear all worker data.
 	void clear()
@@ -31,10 +31,11 @@ static inline First&& GetFirst(First&& f, Rest&&... r)
 
 /**
  * Universal blit function implementation.
+ * @tparam WholeRows if true `f` is called once per row with row size and references to first pixels of row.
  * @param f called function.
  * @param src source surfaces control objects.
  */
-template<typename Func, typename... SrcType>
+template<bool WholeRows = false, typename Func, typename... SrcType>
 static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
 {
 	//get basic draw range in 2d space
@@ -77,22 +78,30 @@ static inline void ShaderDrawImpl(Func&& f, helper::controler<SrcType>... src)
 		(src.set_x(begin_x, end_x), ...);
 
 		int size_x = end_x-begin_x;
-		//iteration on x-axis
-		for (int x = size_x / 4; x>0; --x)
-		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
-		}
-		if (size_x & 2)
+		if constexpr (WholeRows)
 		{
-			f(src.get_ref()...); (src.inc_x(), ...);
-			f(src.get_ref()...); (src.inc_x(), ...);
+			//whole row at once, pixels of surfaces are next to each other
+			f(size_x, src.get_ref()...);
 		}
-		if (size_x & 1)
+		else
 		{
-			f(src.get_ref()...); (src.inc_x(), ...);
+			//iteration on x-axis
+			for (int x = size_x / 4; x>0; --x)
+			{
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+			}
+			if (size_x & 2)
+			{
+				f(src.get_ref()...); (src.inc_x(), ...);
+				f(src.get_ref()...); (src.inc_x(), ...);
+			}
+			if (size_x & 1)
+			{
+				f(src.get_ref()...); (src.inc_x(), ...);
+			}
 		}
 	}
 
@@ -110,6 +119,18 @@ static inline void ShaderDraw(const SrcType&... src_frame)
 	ShaderDrawImpl([](auto&&... a){ ColorFunc::func(std::forward<decltype(a)>(a)...); }, helper::controler<SrcType>(src_frame)...);
 }
 
+/**
+ * Universal blit function, working on whole rows.
+ * @tparam RowFunc class that contains static function `func`.
+ * function get row size and first pixels of row, it must not step outside of it.
+ * @param src_frame destination and source surfaces modified by function.
+ */
+template<typename RowFunc, typename... SrcType>
+static inline void ShaderDrawRows(const SrcType&... src_frame)
+{
+	ShaderDrawImpl<true>([](int size, auto&&... a){ RowFunc::func(size, std::forward<decltype(a)>(a)...); }, helper::controler<SrcType>(src_frame)...);
+}
+
 /**
  * Universal blit function.
  * @param f function that modify other arguments.
@@ -29,6 +29,11 @@
 #include "Logger.h"
 #include "SDL2Helpers.h"
 #include "FileMap.h"
+#include "Zoom.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OXCE_SSE2_BLIT
+#include <emmintrin.h>
+#endif
 #ifdef _WIN32
 #include <malloc.h>
 #endif
@@ -933,6 +938,236 @@ void Surface::unlock()
 	SDL_UnlockSurface(_surface.get());
 }
 
+namespace
+{
+
+#ifdef OXCE_SSE2_BLIT
+
+/**
+ * Shades 16 pixels same way as helper::StandardShade.
+ * @param dest destination pixels
+ * @param src source pixels
+ * @param shade value of shade repeated in every byte
+ * @return new destination pixels
+ */
+inline __m128i shadeSSE2(__m128i dest, __m128i src, __m128i shade)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i group = _mm_set1_epi8((char)helper::ColorGroup);
+	const __m128i black = _mm_set1_epi8((char)helper::ColorShade);
+
+	const __m128i newShade = _mm_add_epi8(src, shade);
+	// 0xFF where shade stays in same color group
+	const __m128i sameGroup = _mm_cmpeq_epi8(_mm_and_si128(_mm_xor_si128(newShade, src), group), zero);
+	const __m128i color = _mm_or_si128(_mm_and_si128(sameGroup, newShade), _mm_andnot_si128(sameGroup, black));
+	// 0xFF where source is transparent
+	const __m128i transparent = _mm_cmpeq_epi8(src, zero);
+	return _mm_or_si128(_mm_and_si128(transparent, dest), _mm_andnot_si128(transparent, color));
+}
+
+/**
+ * Shades and recolors 16 pixels same way as helper::ColorReplace.
+ * @param dest destination pixels
+ * @param src source pixels
+ * @param shade value of shade repeated in every byte
+ * @param newColor new color group repeated in every byte
+ * @return new destination pixels
+ */
+inline __m128i colorReplaceSSE2(__m128i dest, __m128i src, __m128i shade, __m128i newColor)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i group = _mm_set1_epi8((char)helper::ColorGroup);
+	const __m128i black = _mm_set1_epi8((char)helper::ColorShade);
+
+	const __m128i newShade = _mm_add_epi8(_mm_and_si128(src, black), shade);
+	// 0xFF where shade stays inside color group
+	const __m128i inGroup = _mm_cmpeq_epi8(_mm_and_si128(newShade, group), zero);
+	const __m128i color = _mm_or_si128(_mm_and_si128(inGroup, _mm_or_si128(newColor, newShade)), _mm_andnot_si128(inGroup, black));
+	// 0xFF where source is transparent
+	const __m128i transparent = _mm_cmpeq_epi8(src, zero);
+	return _mm_or_si128(_mm_and_si128(transparent, dest), _mm_andnot_si128(transparent, color));
+}
+
+/**
+ * Copies non transparent pixels of 16 pixels.
+ * @param dest destination pixels
+ * @param src source pixels
+ * @return new destination pixels
+ */
+inline __m128i maskedCopySSE2(__m128i dest, __m128i src)
+{
+	// 0xFF where source is transparent
+	const __m128i transparent = _mm_cmpeq_epi8(src, _mm_setzero_si128());
+	return _mm_or_si128(_mm_and_si128(transparent, dest), _mm_andnot_si128(transparent, src));
+}
+
+/**
+ * Compares SSE2 kernels with scalar helpers for every source pixel, shade and color group.
+ * @return True if all results match.
+ */
+bool checkSSE2Blit()
+{
+	Uint8 src[16], dest[16], result[16], expected[16];
+	int diff = 0;
+	for (int shade = 0; shade < 256; ++shade)
+	{
+		const __m128i shadeVec = _mm_set1_epi8((char)shade);
+		for (int block = 0; block < 256; block += 16)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				src[i] = (Uint8)(block + i);
+				dest[i] = (Uint8)(255 - block - i * 7);
+			}
+			const __m128i srcVec = _mm_loadu_si128((const __m128i*)src);
+			const __m128i destVec = _mm_loadu_si128((const __m128i*)dest);
+
+			_mm_storeu_si128((__m128i*)result, shadeSSE2(destVec, srcVec, shadeVec));
+			for (int i = 0; i < 16; ++i)
+			{
+				expected[i] = dest[i];
+				helper::StandardShade::func(expected[i], src[i], shade);
+			}
+			diff += memcmp(result, expected, 16) != 0;
+
+			for (int group = 0; group < 16; ++group)
+			{
+				const int newColor = group << 4;
+				_mm_storeu_si128((__m128i*)result, colorReplaceSSE2(destVec, srcVec, shadeVec, _mm_set1_epi8((char)newColor)));
+				for (int i = 0; i < 16; ++i)
+				{
+					expected[i] = dest[i];
+					helper::ColorReplace::func(expected[i], src[i], shade, newColor);
+				}
+				diff += memcmp(result, expected, 16) != 0;
+			}
+
+			if (shade == 0)
+			{
+				_mm_storeu_si128((__m128i*)result, maskedCopySSE2(destVec, srcVec));
+				for (int i = 0; i < 16; ++i)
+				{
+					expected[i] = src[i] ? src[i] : dest[i];
+				}
+				diff += memcmp(result, expected, 16) != 0;
+			}
+		}
+	}
+	if (diff)
+	{
+		Log(LOG_ERROR) << "SSE2 blit kernels differ from scalar ones in " << diff << " checks, using scalar blit.";
+	}
+	return diff == 0;
+}
+
+#endif
+
+/**
+ * Is SSE2 version of blit available.
+ * SSE2 kernels are compared with scalar helpers once, before first use.
+ */
+bool useSSE2Blit()
+{
+#ifdef OXCE_SSE2_BLIT
+	static const bool sse2 = Zoom::haveSSE2() && checkSSE2Blit();
+	return sse2;
+#else
+	return false;
+#endif
+}
+
+/**
+ * Row version of helper::StandardShade, using SSE2 when available.
+ */
+struct StandardShadeRow
+{
+	static inline void func(int size, Uint8& dest, const Uint8& src, const int& shade)
+	{
+		Uint8* d = &dest;
+		const Uint8* s = &src;
+		int i = 0;
+#ifdef OXCE_SSE2_BLIT
+		if (useSSE2Blit())
+		{
+			const __m128i shadeVec = _mm_set1_epi8((char)shade);
+			for (; i + 16 <= size; i += 16)
+			{
+				const __m128i srcVec = _mm_loadu_si128((const __m128i*)(s + i));
+				const __m128i destVec = _mm_loadu_si128((const __m128i*)(d + i));
+				_mm_storeu_si128((__m128i*)(d + i), shadeSSE2(destVec, srcVec, shadeVec));
+			}
+		}
+#endif
+		for (; i < size; ++i)
+		{
+			helper::StandardShade::func(d[i], s[i], shade);
+		}
+	}
+};
+
+/**
+ * Row version of helper::ColorReplace, using SSE2 when available.
+ */
+struct ColorReplaceRow
+{
+	static inline void func(int size, Uint8& dest, const Uint8& src, const int& shade, const int& newColor)
+	{
+		Uint8* d = &dest;
+		const Uint8* s = &src;
+		int i = 0;
+#ifdef OXCE_SSE2_BLIT
+		if (useSSE2Blit())
+		{
+			const __m128i shadeVec = _mm_set1_epi8((char)shade);
+			const __m128i colorVec = _mm_set1_epi8((char)newColor);
+			for (; i + 16 <= size; i += 16)
+			{
+				const __m128i srcVec = _mm_loadu_si128((const __m128i*)(s + i));
+				const __m128i destVec = _mm_loadu_si128((const __m128i*)(d + i));
+				_mm_storeu_si128((__m128i*)(d + i), colorReplaceSSE2(destVec, srcVec, shadeVec, colorVec));
+			}
+		}
+#endif
+		for (; i < size; ++i)
+		{
+			helper::ColorReplace::func(d[i], s[i], shade, newColor);
+		}
+	}
+};
+
+/**
+ * Row copy of non transparent pixels, using SSE2 when available.
+ */
+struct MaskedCopyRow
+{
+	static inline void func(int size, Uint8& dest, const Uint8& src)
+	{
+		Uint8* d = &dest;
+		const Uint8* s = &src;
+		int i = 0;
+#ifdef OXCE_SSE2_BLIT
+		if (useSSE2Blit())
+		{
+			for (; i + 16 <= size; i += 16)
+			{
+				const __m128i srcVec = _mm_loadu_si128((const __m128i*)(s + i));
+				const __m128i destVec = _mm_loadu_si128((const __m128i*)(d + i));
+				_mm_storeu_si128((__m128i*)(d + i), maskedCopySSE2(destVec, srcVec));
+			}
+		}
+#endif
+		for (; i < size; ++i)
+		{
+			if (s[i])
+			{
+				d[i] = s[i];
+			}
+		}
+	}
+};
+
+} //namespace
+
 /**
  * Specific blit function to blit battlescape terrain data in different shades in a fast way.
  */
@@ -949,12 +1184,32 @@ void Surface::blitRaw(SurfaceRaw<Uint8> destSurf, SurfaceRaw<const Uint8> srcSur
 	{
 		--newBaseColor;
 		newBaseColor <<= 4;
-		ShaderDraw<helper::ColorReplace>(ShaderSurface(destSurf), src, ShaderScalar(shade), ShaderScalar(newBaseColor));
+		ShaderDrawRows<ColorReplaceRow>(ShaderSurface(destSurf), src, ShaderScalar(shade), ShaderScalar(newBaseColor));
 	}
 	else
 	{
-		ShaderDraw<helper::StandardShade>(ShaderSurface(destSurf), src, ShaderScalar(shade));
+		ShaderDrawRows<StandardShadeRow>(ShaderSurface(destSurf), src, ShaderScalar(shade));
+	}
+}
+
+/**
+ * Blit function copying all non transparent pixels, used for sprites that have shade already applied.
+ * @param destSurf surface to blit to
+ * @param srcSurf surface to blit from
+ * @param x
+ * @param y
+ * @param half some tiles are blitted only the right half
+ */
+void Surface::blitMasked(SurfaceRaw<Uint8> destSurf, SurfaceRaw<const Uint8> srcSurf, int x, int y, bool half)
+{
+	ShaderMove<const Uint8> src(srcSurf, x, y);
+	if (half)
+	{
+		GraphSubset g = src.getDomain();
+		g.beg_x = g.end_x/2;
+		src.setDomain(g);
 	}
+	ShaderDrawRows<MaskedCopyRow>(ShaderSurface(destSurf), src);
 }
 
 /**
@@ -988,7 +1243,80 @@ void Surface::blitNShade(SurfaceRaw<Uint8> surface, int x, int y, int shade, Gra
 
 	dest.setDomain(range);
 
-	ShaderDraw<helper::StandardShade>(dest, src, ShaderScalar(shade));
+	ShaderDrawRows<StandardShadeRow>(dest, src, ShaderScalar(shade));
+}
+
+/**
+ * Blits lot of shaded sprites with row kernels used by blitRaw and with
+ * generic per pixel ShaderDraw, logs how long each took and if they differ.
+ */
+void Surface::benchmarkBlit()
+{
+	const int runs = 50;
+	const int spriteWidth = 32, spriteHeight = 40;
+	const int width = 320, height = 200;
+
+	// terrain like sprite, with transparent areas and every shade of color groups
+	std::vector<Uint8> sprite(spriteWidth * spriteHeight);
+	for (int i = 0; i < (int)sprite.size(); ++i)
+	{
+		Uint32 c = i * 2654435761u;
+		sprite[i] = (i % 11 < 3) ? 0 : (Uint8)(c >> 24);
+	}
+	std::vector<Uint8> generic(width * height), fast(width * height);
+
+	auto drawAll = [&](std::vector<Uint8> &dest, bool useGeneric)
+	{
+		SurfaceRaw<Uint8> destSurf(dest, width, height);
+		SurfaceRaw<const Uint8> srcSurf(sprite, spriteWidth, spriteHeight);
+		for (int y = -spriteHeight / 2, i = 0; y < height; y += 7)
+		{
+			for (int x = -spriteWidth / 2; x < width; x += 11, ++i)
+			{
+				const int shade = i % 17;
+				const int newColor = (i % 3 == 0) ? (i % 16) << 4 : -1;
+				ShaderMove<const Uint8> src(srcSurf, x, y);
+				if (useGeneric)
+				{
+					if (newColor >= 0)
+						ShaderDraw<helper::ColorReplace>(ShaderSurface(destSurf), src, ShaderScalar(shade), ShaderScalar(newColor));
+					else
+						ShaderDraw<helper::StandardShade>(ShaderSurface(destSurf), src, ShaderScalar(shade));
+				}
+				else
+				{
+					if (newColor >= 0)
+						ShaderDrawRows<ColorReplaceRow>(ShaderSurface(destSurf), src, ShaderScalar(shade), ShaderScalar(newColor));
+					else
+						ShaderDrawRows<StandardShadeRow>(ShaderSurface(destSurf), src, ShaderScalar(shade));
+				}
+			}
+		}
+	};
+
+	double ms[2];
+	for (int useGeneric = 0; useGeneric < 2; ++useGeneric)
+	{
+		std::vector<Uint8> &dest = useGeneric ? generic : fast;
+		Uint32 start = SDL_GetTicks();
+		for (int i = 0; i < runs; ++i)
+		{
+			std::fill(dest.begin(), dest.end(), (Uint8)i);
+			drawAll(dest, useGeneric != 0);
+		}
+		ms[useGeneric] = (SDL_GetTicks() - start) / (double)runs;
+	}
+
+	int diff = 0;
+	for (int i = 0; i < width * height; ++i)
+	{
+		if (generic[i] != fast[i])
+		{
+			++diff;
+		}
+	}
+	const SeverityLevel level = diff ? LOG_ERROR : LOG_INFO;
+	Log(level) << "Blit benchmark (" << (useSSE2Blit() ? "SSE2" : "scalar") << "): " << ms[1] << " ms/run generic, " << ms[0] << " ms/run row kernels, " << diff << " pixels differ.";
 }
 
 /**
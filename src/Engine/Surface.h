@@ -315,10 +315,14 @@ public:
 	void unlock();
 	/// Specific blit function to blit battlescape terrain data in different shades in a fast way.
 	static void blitRaw(SurfaceRaw<Uint8> dest, SurfaceRaw<const Uint8> src, int x, int y, int shade, bool half = false, int newBaseColor = 0);
+	/// Blit function copying non transparent pixels, for sprites with shade already applied.
+	static void blitMasked(SurfaceRaw<Uint8> dest, SurfaceRaw<const Uint8> src, int x, int y, bool half = false);
 	/// Specific blit function to blit battlescape terrain data in different shades in a fast way.
 	void blitNShade(SurfaceRaw<Uint8> surface, int x, int y, int shade = 0, bool half = false, int newBaseColor = 0) const;
 	/// Specific blit function to blit battlescape terrain data in different shades in a fast way.
 	void blitNShade(SurfaceRaw<Uint8> surface, int x, int y, int shade, GraphSubset range) const;
+	/// Compares fast shade blits with generic ones and measures their speed.
+	static void benchmarkBlit();
 	/// Invalidate the surface: force it to be redrawn
 	void invalidate(bool valid = true);
 
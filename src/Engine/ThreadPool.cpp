@@ -0,0 +1,178 @@
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include "ThreadPool.h"
+#include "Options.h"
+
+namespace OpenXcom
+{
+
+namespace
+{
+
+/// Set for threads currently executing a job, nested jobs are run in place.
+thread_local bool insideJob = false;
+
+}//namespace
+
+/**
+ * Creates a pool and starts its worker threads.
+ * @param threads Total number of threads, the calling thread is counted as one of them.
+ */
+ThreadPool::ThreadPool(int threads) : _job(nullptr), _next(0), _count(0), _busy(0), _generation(0), _quit(false)
+{
+	for (int i = 1; i < threads; ++i)
+	{
+		_threads.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+/**
+ * Signals the worker threads to quit and waits for them.
+ */
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_start.notify_all();
+	for (auto& t : _threads)
+	{
+		t.join();
+	}
+}
+
+/**
+ * Waits for new jobs and helps to finish them.
+ * @param worker Index of this thread.
+ */
+void ThreadPool::work(int worker)
+{
+	insideJob = true;
+	unsigned seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_start.wait(lock, [&]{ return _quit || _generation != seen; });
+			if (_quit)
+			{
+				return;
+			}
+			seen = _generation;
+		}
+
+		runJob(worker);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (--_busy == 0)
+			{
+				_finish.notify_one();
+			}
+		}
+	}
+}
+
+/**
+ * Takes parts of the current job one by one until all are taken.
+ * First exception thrown stops the job and is passed to the caller.
+ * @param worker Index of this thread.
+ */
+void ThreadPool::runJob(int worker)
+{
+	int i;
+	while ((i = _next.fetch_add(1)) < _count)
+	{
+		try
+		{
+			(*_job)(i, worker);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_error)
+			{
+				_error = std::current_exception();
+			}
+			_next = _count;
+		}
+	}
+}
+
+/**
+ * Calls the job for each index in range, the order of calls is unspecified.
+ * Returns after all calls have finished. Called from inside of a job it runs
+ * all parts in place on the current thread.
+ * @param count Number of parts.
+ * @param job Function to call for each part.
+ */
+void ThreadPool::parallelFor(int count, const Job &job)
+{
+	if (_threads.empty() || count <= 1 || insideJob)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			job(i, 0);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> call(_callMutex);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_job = &job;
+		_count = count;
+		_next = 0;
+		_busy = (int)_threads.size();
+		_error = nullptr;
+		++_generation;
+	}
+	_start.notify_all();
+
+	insideJob = true;
+	runJob(0);
+	insideJob = false;
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_finish.wait(lock, [&]{ return _busy == 0; });
+		_job = nullptr;
+		std::swap(error, _error);
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+/**
+ * Gets the pool shared by the engine, created on first use.
+ * Changes to the thread count option apply after restart.
+ * @return Shared pool.
+ */
+ThreadPool &ThreadPool::getDefault()
+{
+	static ThreadPool pool(Options::oxceWorkerThreads > 0 ? Options::oxceWorkerThreads : std::max(1, (int)std::thread::hardware_concurrency()));
+	return pool;
+}
+
+}
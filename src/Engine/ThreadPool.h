@@ -0,0 +1,74 @@
+#pragma once
+/*
+ * Copyright 2010-2016 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+namespace OpenXcom
+{
+
+/**
+ * Fixed set of worker threads used to split a job into independent parts.
+ * The calling thread works on the job too and waits until all parts are done,
+ * so callers see it as a normal (blocking) function call.
+ */
+class ThreadPool
+{
+public:
+	/// Job callback, gets index of part and index of thread (0 is caller thread).
+	using Job = std::function<void(int index, int worker)>;
+
+private:
+	std::vector<std::thread> _threads;
+	std::mutex _callMutex, _mutex;
+	std::condition_variable _start, _finish;
+	const Job *_job;
+	std::atomic<int> _next;
+	int _count, _busy;
+	unsigned _generation;
+	bool _quit;
+	std::exception_ptr _error;
+
+	/// Main loop of a worker thread.
+	void work(int worker);
+	/// Processes parts of the current job until none are left.
+	void runJob(int worker);
+public:
+	/// Creates a pool with the given total number of threads (caller included).
+	ThreadPool(int threads);
+	/// Stops all worker threads.
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// Gets the total number of threads (caller included), useful for sizing per-worker buffers.
+	int getThreadCount() const { return (int)_threads.size() + 1; }
+	/// Calls the job for every index in [0, count), spread over all threads.
+	void parallelFor(int count, const Job &job);
+
+	/// Gets the shared pool sized by the oxceWorkerThreads option.
+	static ThreadPool &getDefault();
+};
+
+}
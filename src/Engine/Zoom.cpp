@@ -23,6 +23,8 @@
 #include "Logger.h"
 #include "Options.h"
 #include "Screen.h"
+#include "ThreadPool.h"
+#include <algorithm>
 
 #include "OpenGL.h"
 
@@ -61,6 +63,76 @@
 namespace OpenXcom
 {
 
+namespace
+{
+
+/**
+ * Runs a scaler on horizontal slices of the source image, spread over the worker threads.
+ * @param height Height of the source image.
+ * @param parallel Use worker threads.
+ * @param func Scaler called with first and last (exclusive) source row of a slice.
+ */
+template<typename F>
+void scaleSlices(int yBegin, int yEnd, bool parallel, F func)
+{
+	ThreadPool &pool = ThreadPool::getDefault();
+	const int height = yEnd - yBegin;
+	// xBRZ suggests at least 8-16 rows per slice, more slices than threads keep them busy when some finish early
+	const int slices = std::min(pool.getThreadCount() * 2, height / 16);
+	if (!parallel || pool.getThreadCount() <= 1 || slices <= 1)
+	{
+		func(yBegin, yEnd);
+		return;
+	}
+	pool.parallelFor(slices, [&](int i, int worker)
+	{
+		func(yBegin + height * i / slices, yBegin + height * (i + 1) / slices);
+	});
+}
+
+/**
+ * Scales 32-bit image with xBRZ, only source rows from yBegin to yEnd are written to dst.
+ */
+void scaleXBRZ(size_t factor, SDL_Surface *src, SDL_Surface *dst, bool parallel, int yBegin, int yEnd)
+{
+	scaleSlices(yBegin, yEnd, parallel, [&](int yFirst, int yLast)
+	{
+		xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB, xbrz::ScalerCfg(), yFirst, yLast);
+	});
+}
+
+/**
+ * Scales 32-bit image with HQx, only source rows from yBegin to yEnd are written to dst.
+ */
+void scaleHQX(int factor, SDL_Surface *src, SDL_Surface *dst, bool parallel, int yBegin, int yEnd)
+{
+	static bool initDone = false;
+
+	if (!initDone)
+	{
+		hqxInit();
+		initDone = true;
+	}
+
+	scaleSlices(yBegin, yEnd, parallel, [&](int yFirst, int yLast)
+	{
+		switch (factor)
+		{
+		case 2:
+			hq2x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+			break;
+		case 3:
+			hq3x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+			break;
+		case 4:
+			hq4x_32_rb_slice((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h, yFirst, yLast);
+			break;
+		}
+	});
+}
+
+}
+
 
 /**
  * Optimized 8-bit zoomer for resizing by a factor of 2. Doesn't flip.
@@ -664,8 +736,10 @@ bool Zoom::haveSSE2()
  * @param leftBlackBand Size of left black band in pixels (letterboxing).
  * @param rightBlackBand Size of right black band in pixels (letterboxing).
  * @param glOut OpenGL output.
+ * @param yBegin First row of src that changed since the last flip.
+ * @param yEnd Row of src after the last one that changed, -1 for the whole surface.
  */
-void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut)
+void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, int bottomBlackBand, int leftBlackBand, int rightBlackBand, OpenGL *glOut, int yBegin, int yEnd)
 {
 	int dstWidth = dst->w - leftBlackBand - rightBlackBand;
 	int dstHeight = dst->h - topBlackBand - bottomBlackBand;
@@ -683,7 +757,7 @@ void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, in
 	}
 	else if (topBlackBand <= 0 && bottomBlackBand <= 0 && leftBlackBand <= 0 && rightBlackBand <= 0)
 	{
-		_zoomSurfaceY(src, dst, 0, 0);
+		_zoomSurfaceY(src, dst, 0, 0, yBegin, yEnd);
 	}
 	else if (dstWidth == src->w && dstHeight == src->h)
 	{
@@ -717,9 +791,11 @@ void Zoom::flipWithZoom(SDL_Surface *src, SDL_Surface *dst, int topBlackBand, in
  * @param dst The zoomed surface (output).
  * @param flipx Flag indicating if the image should be horizontally flipped.
  * @param flipy Flag indicating if the image should be vertically flipped.
+ * @param yBegin First row of src to zoom, only xBRZ and HQx skip the other rows.
+ * @param yEnd Row of src after the last one to zoom, -1 for the whole surface.
  * @return 0 for success or -1 for error.
  */
-int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy)
+int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int flipy, int yBegin, int yEnd)
 {
 	int x, y;
 	static Uint32 *sax, *say;
@@ -729,6 +805,11 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	int dgap;
 	static bool proclaimed = false;
 
+	if (yEnd < 0)
+	{
+		yEnd = src->h;
+	}
+
 	if (Screen::use32bitScaler())
 	{
 		if (Options::useXBRZFilter)
@@ -738,7 +819,7 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 			{
 				if (dst->w == src->w * (int)factor && dst->h == src->h * (int)factor)
 				{
-					xbrz::scale(factor, (uint32_t*)src->pixels, (uint32_t*)dst->pixels, src->w, src->h, xbrz::RGB);
+					scaleXBRZ(factor, src, dst, true, yBegin, yEnd);
 					return 0;
 				}
 			}
@@ -746,32 +827,13 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 
 		if (Options::useHQXFilter)
 		{
-			static bool initDone = false;
-
-			if (!initDone)
-			{
-				hqxInit();
-				initDone = true;
-			}
-
-			// HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
-
-			if (dst->w == src->w * 2 && dst->h == src->h * 2)
-			{
-				hq2x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
-				return 0;
-			}
-
-			if (dst->w == src->w * 3 && dst->h == src->h * 3)
+			for (int factor = 2; factor <= 4; factor++)
 			{
-				hq3x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
-				return 0;
-			}
-
-			if (dst->w == src->w * 4 && dst->h == src->h * 4)
-			{
-				hq4x_32_rb((uint32_t*)src->pixels, src->pitch, (uint32_t*)dst->pixels, dst->pitch, src->w, src->h);
-				return 0;
+				if (dst->w == src->w * factor && dst->h == src->h * factor)
+				{
+					scaleHQX(factor, src, dst, true, yBegin, yEnd);
+					return 0;
+				}
 			}
 		}
 	}
@@ -936,6 +998,66 @@ int Zoom::_zoomSurfaceY(SDL_Surface * src, SDL_Surface * dst, int flipx, int fli
 	return 0;
 }
 
+/**
+ * Measures speed of 32-bit scalers for every factor, on one thread and on the worker threads.
+ * Source image has the size of the game screen, results are written to the log.
+ */
+void Zoom::benchmark()
+{
+	const int frames = 10;
+	const int width = Options::baseXResolution;
+	const int height = Options::baseYResolution;
 
+	SDL_Surface *src = SDL_CreateRGBSurface(SDL_SWSURFACE, width, height, 32, 0xFF0000, 0x00FF00, 0x0000FF, 0);
+	if (!src)
+	{
+		return;
+	}
+	// blocky pattern with some edges, close to game graphics
+	SDL_LockSurface(src);
+	for (int y = 0; y < height; ++y)
+	{
+		Uint32 *row = (Uint32*)((Uint8*)src->pixels + y * src->pitch);
+		for (int x = 0; x < width; ++x)
+		{
+			Uint32 c = (x / 7) * 2654435761u ^ (y / 5) * 40503u;
+			row[x] = ((x + y) % 23 == 0) ? 0 : (c & 0xE0E0E0);
+		}
+	}
+	SDL_UnlockSurface(src);
+
+	auto run = [&](const char *name, int factor, auto func)
+	{
+		SDL_Surface *dst = SDL_CreateRGBSurface(SDL_SWSURFACE, width * factor, height * factor, 32, 0xFF0000, 0x00FF00, 0x0000FF, 0);
+		if (!dst)
+		{
+			return;
+		}
+		double ms[2];
+		for (int parallel = 0; parallel < 2; ++parallel)
+		{
+			func(factor, src, dst, parallel != 0); // warm up
+			Uint32 start = SDL_GetTicks();
+			for (int i = 0; i < frames; ++i)
+			{
+				func(factor, src, dst, parallel != 0);
+			}
+			ms[parallel] = (SDL_GetTicks() - start) / (double)frames;
+		}
+		Log(LOG_INFO) << "Scaler benchmark " << name << " " << factor << "x (" << width << "x" << height << "): " << ms[0] << " ms/frame on one thread, " << ms[1] << " ms/frame on " << ThreadPool::getDefault().getThreadCount() << " threads.";
+		SDL_FreeSurface(dst);
+	};
+
+	for (int factor = 2; factor <= 6; ++factor)
+	{
+		run("xBRZ", factor, [](int f, SDL_Surface *s, SDL_Surface *d, bool p) { scaleXBRZ(f, s, d, p, 0, s->h); });
+	}
+	for (int factor = 2; factor <= 4; ++factor)
+	{
+		run("HQx", factor, [](int f, SDL_Surface *s, SDL_Surface *d, bool p) { scaleHQX(f, s, d, p, 0, s->h); });
+	}
+
+	SDL_FreeSurface(src);
 }
 
+}
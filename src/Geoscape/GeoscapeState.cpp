@@ -638,6 +638,11 @@ void GeoscapeState::handle(Action *action)
 					ab->setDiscovered(true);
 				}
 			}
+			// "ctrl-8"
+			if (action->getDetails()->key.keysym.sym == SDLK_8)
+			{
+				_txtDebug->setText(_globe->benchmarkHitTest());
+			}
 			// "ctrl-a"
 			if (action->getDetails()->key.keysym.sym == SDLK_a)
 			{
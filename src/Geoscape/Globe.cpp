@@ -53,6 +53,9 @@
 #include "../Mod/Texture.h"
 #include "../Interface/Cursor.h"
 #include "../Engine/Screen.h"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/Logger.h"
+#include <sstream>
 
 namespace OpenXcom
 {
@@ -286,11 +289,10 @@ struct CreateShadow
 		return Globe::OCEAN_SHADING && dest >= Globe::OCEAN_COLOR && dest < Globe::OCEAN_COLOR + 32;
 	}
 
-	static inline void func(Uint8& dest, const Cord& earth, const Cord& sun, const Sint16& noise)
+	static inline void func(Uint8& dest, const Uint8& shadow)
 	{
-		if (dest && earth.z)
+		if (dest && shadow != NoShadow)
 		{
-			const Uint8 shadow = getShadowValue(earth, sun, noise);
 			//this pixel is ocean
 			if (isOcean(dest))
 			{
@@ -307,17 +309,95 @@ struct CreateShadow
 			dest = 0;
 		}
 	}
+
+	/// Value in shadow map of pixels outside of globe.
+	static constexpr Uint8 NoShadow = 0xFF;
 };
 
-struct CreateShadowWithoutCache
+struct CreateShadowMap
 {
-	static inline void func(Uint8& dest, const helper::Offset& offset, const Cord& sun, const Sint16& noise, const int& radius)
+	static inline void func(Uint8& shadow, const Cord& earth, const Cord& sun, const Sint16& noise)
+	{
+		shadow = earth.z ? CreateShadow::getShadowValue(earth, sun, noise) : CreateShadow::NoShadow;
+	}
+};
+
+struct CreateShadowMapWithoutCache
+{
+	static inline void func(Uint8& shadow, const helper::Offset& offset, const Cord& sun, const Sint16& noise, const int& radius)
 	{
 		Cord earth = static_data.circle_norm(0., 0., radius, offset.x, offset.y);
-		CreateShadow::func(dest, earth, sun, noise);
+		CreateShadowMap::func(shadow, earth, sun, noise);
 	}
 };
 
+/**
+ * Checks if a point is inside a polygon, as seen on the globe centered on that point.
+ * @param polygon Pointer to the polygon.
+ * @param lon Longitude of the point.
+ * @param coslat Cosine of the latitude of the point.
+ * @param sinlat Sine of the latitude of the point.
+ * @return True if the point is inside.
+ */
+bool insidePolygon(const Polygon *polygon, double lon, double coslat, double sinlat)
+{
+	const double zDiscard=0.75f;
+	double x, y, z, x2, y2;
+	double clat, clon;
+	z = 0;
+	for (int j = 0; j < polygon->getPoints(); ++j)
+	{
+		z = coslat * cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j) - lon) + sinlat * sin(polygon->getLatitude(j));
+		if (z<zDiscard) break; //discarded
+	}
+	if (z<zDiscard) return false; //discarded
+
+	bool odd = false;
+
+	clat = polygon->getLatitude(0); //initial point
+	clon = polygon->getLongitude(0);
+	x = cos(clat) * sin(clon - lon);
+	y = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
+
+	for (int j = 0; j < polygon->getPoints(); ++j)
+	{
+		int k = (j + 1) % polygon->getPoints(); //index of next point in poly
+		clat = polygon->getLatitude(k);
+		clon = polygon->getLongitude(k);
+
+		x2 = cos(clat) * sin(clon - lon);
+		y2 = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
+		if ( ((y>0)!=(y2>0)) && (0 < (x2-x)*(0-y)/(y2-y)+x) )
+			odd = !odd;
+		x = x2;
+		y = y2;
+
+	}
+	return odd;
+}
+
+/**
+ * Calls a function on horizontal bands of the globe, spread over the worker threads.
+ * @param height Height of the globe.
+ * @param func Function called with first and last (exclusive) row of a band.
+ */
+template<typename F>
+void drawBands(int height, F func)
+{
+	ThreadPool &pool = ThreadPool::getDefault();
+	// more bands than threads keep them busy when the ones outside of the globe finish early
+	const int bands = std::min(pool.getThreadCount() * 4, height / 16);
+	if (pool.getThreadCount() <= 1 || bands <= 1)
+	{
+		func(0, height);
+		return;
+	}
+	pool.parallelFor(bands, [&](int i, int worker)
+	{
+		func(height * i / bands, height * (i + 1) / bands);
+	});
+}
+
 }//namespace
 
 
@@ -358,6 +438,7 @@ Globe::Globe(Game* game, int cenX, int cenY, int width, int height, int x, int y
 	setupRadii(width, height);
 	setZoom(_zoom);
 
+	cachePolygonGrid();
 	cachePolygons();
 }
 
@@ -452,48 +533,176 @@ bool Globe::pointBack(double lon, double lat) const
 	return c < 0.0;
 }
 
+/**
+ * Gets the first polygon that contains a point, only polygons
+ * from the grid cell of that point need to be checked.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Pointer to the polygon or NULL if the point is in the ocean.
+ */
 Polygon* Globe::getPolygonFromLonLat(double lon, double lat) const
 {
-	const double zDiscard=0.75f;
 	double coslat = cos(lat);
 	double sinlat = sin(lat);
 
+	for (auto* polygon : _polygonGrid[getPolygonGridCell(lon, lat)])
+	{
+		if (insidePolygon(polygon, lon, coslat, sinlat))
+		{
+			return polygon;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Sorts all globe polygons into a longitude/latitude grid, each polygon
+ * goes in every cell touched by a spherical cap holding all its points.
+ * A point can only be inside a polygon when it lies in that cap,
+ * so checking the polygons of the cell with the point is enough.
+ * Polygons keep their order in cells, the first one found is the same
+ * as when checking all polygons.
+ */
+void Globe::cachePolygonGrid()
+{
+	_polygonGrid.assign(POLYGON_GRID_LON * POLYGON_GRID_LAT, std::vector<Polygon*>());
+
 	for (auto* polygon : *_rules->getPolygons())
 	{
-		double x, y, z, x2, y2;
-		double clat, clon;
-		z = 0;
+		Cord center(0.0, 0.0, 0.0);
 		for (int j = 0; j < polygon->getPoints(); ++j)
 		{
-			z = coslat * cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j) - lon) + sinlat * sin(polygon->getLatitude(j));
-			if (z<zDiscard) break; //discarded
+			center += Cord(cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j)), cos(polygon->getLatitude(j)) * sin(polygon->getLongitude(j)), sin(polygon->getLatitude(j)));
 		}
-		if (z<zDiscard) continue; //discarded
 
-		bool odd = false;
-
-		clat = polygon->getLatitude(0); //initial point
-		clon = polygon->getLongitude(0);
-		x = cos(clat) * sin(clon - lon);
-		y = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
+		// by default polygon is in all cells
+		double latMin = -M_PI / 2, latMax = M_PI / 2;
+		double lonCenter = 0.0, lonHalf = M_PI;
+		const double norm = center.norm();
+		if (norm > 0.000001)
+		{
+			center *= 1. / norm;
+			double radius = 0.0;
+			for (int j = 0; j < polygon->getPoints(); ++j)
+			{
+				double dot = cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j)) * center.x + cos(polygon->getLatitude(j)) * sin(polygon->getLongitude(j)) * center.y + sin(polygon->getLatitude(j)) * center.z;
+				radius = std::max(radius, acos(Clamp(dot, -1.0, 1.0)));
+			}
+			// only caps smaller than half of sphere hold everything between their points
+			if (radius < M_PI / 2)
+			{
+				radius += 0.001; //rounding errors
+				const double latCenter = asin(Clamp(center.z, -1.0, 1.0));
+				lonCenter = atan2(center.y, center.x);
+				latMin = latCenter - radius;
+				latMax = latCenter + radius;
+				// cap without a pole spans limited range of longitude
+				if (latMin > -M_PI / 2 && latMax < M_PI / 2)
+				{
+					lonHalf = asin(Clamp(sin(radius) / cos(latCenter), -1.0, 1.0));
+				}
+			}
+		}
 
-		for (int j = 0; j < polygon->getPoints(); ++j)
+		const int latBegin = Clamp((int)floor((latMin + M_PI / 2) / M_PI * POLYGON_GRID_LAT), 0, POLYGON_GRID_LAT - 1);
+		const int latEnd = Clamp((int)floor((latMax + M_PI / 2) / M_PI * POLYGON_GRID_LAT), 0, POLYGON_GRID_LAT - 1);
+		int lonBegin = (int)floor((lonCenter - lonHalf) / (2 * M_PI) * POLYGON_GRID_LON);
+		int lonEnd = (int)floor((lonCenter + lonHalf) / (2 * M_PI) * POLYGON_GRID_LON);
+		if (lonEnd - lonBegin >= POLYGON_GRID_LON - 1)
+		{
+			lonBegin = 0;
+			lonEnd = POLYGON_GRID_LON - 1;
+		}
+		for (int j = latBegin; j <= latEnd; ++j)
 		{
-			int k = (j + 1) % polygon->getPoints(); //index of next point in poly
-			clat = polygon->getLatitude(k);
-			clon = polygon->getLongitude(k);
+			for (int i = lonBegin; i <= lonEnd; ++i)
+			{
+				const int wrapped = (i % POLYGON_GRID_LON + POLYGON_GRID_LON) % POLYGON_GRID_LON;
+				_polygonGrid[j * POLYGON_GRID_LON + wrapped].push_back(polygon);
+			}
+		}
+	}
+}
+
+/**
+ * Gets the grid cell of a point on the globe.
+ * @param lon Longitude of the point.
+ * @param lat Latitude of the point.
+ * @return Index of the cell in the polygon grid.
+ */
+size_t Globe::getPolygonGridCell(double lon, double lat) const
+{
+	double wrappedLon = fmod(lon, 2 * M_PI);
+	if (wrappedLon < 0)
+	{
+		wrappedLon += 2 * M_PI;
+	}
+	const int i = Clamp((int)(wrappedLon / (2 * M_PI) * POLYGON_GRID_LON), 0, POLYGON_GRID_LON - 1);
+	const int j = Clamp((int)((lat + M_PI / 2) / M_PI * POLYGON_GRID_LAT), 0, POLYGON_GRID_LAT - 1);
+	return j * POLYGON_GRID_LON + i;
+}
 
-			x2 = cos(clat) * sin(clon - lon);
-			y2 = coslat * sin(clat) - sinlat * cos(clat) * cos(clon - lon);
-			if ( ((y>0)!=(y2>0)) && (0 < (x2-x)*(0-y)/(y2-y)+x) )
-				odd = !odd;
-			x = x2;
-			y = y2;
+/**
+ * Measures finding polygons with the polygon grid against
+ * checking every polygon, on random points over the whole globe.
+ * Logs the timings and the number of points where both disagree.
+ * @return Short summary of the results.
+ */
+std::string Globe::benchmarkHitTest() const
+{
+	const int count = 100000;
+	RNG::RandomState random(0x1234567);
+	std::vector<std::pair<double, double> > points;
+	for (int i = 0; i < count; ++i)
+	{
+		// uniform over the sphere surface
+		double lon = random.generate(0, 1 << 20) * (2 * M_PI / (1 << 20));
+		double lat = asin(random.generate(-(1 << 20), 1 << 20) / (double)(1 << 20));
+		points.push_back(std::make_pair(lon, lat));
+	}
+
+	size_t biggestCell = 0, totalCells = 0;
+	for (auto& cell : _polygonGrid)
+	{
+		biggestCell = std::max(biggestCell, cell.size());
+		totalCells += cell.size();
+	}
 
+	std::vector<Polygon*> linear;
+	Uint32 start = SDL_GetTicks();
+	for (auto& p : points)
+	{
+		Polygon *found = NULL;
+		double coslat = cos(p.second);
+		double sinlat = sin(p.second);
+		for (auto* polygon : *_rules->getPolygons())
+		{
+			if (insidePolygon(polygon, p.first, coslat, sinlat))
+			{
+				found = polygon;
+				break;
+			}
 		}
-		if (odd) return polygon;
+		linear.push_back(found);
 	}
-	return NULL;
+	Uint32 linearTime = std::max(SDL_GetTicks() - start, 1u);
+
+	start = SDL_GetTicks();
+	int land = 0, diff = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		Polygon *found = getPolygonFromLonLat(points[i].first, points[i].second);
+		land += found != NULL;
+		diff += found != linear[i];
+	}
+	Uint32 gridTime = std::max(SDL_GetTicks() - start, 1u);
+
+	Log(LOG_INFO) << "Globe hit test benchmark: " << _rules->getPolygons()->size() << " polygons, " << totalCells / (double)_polygonGrid.size() << " average and " << biggestCell << " most polygons per grid cell.";
+	Log(LOG_INFO) << "Globe hit test benchmark: " << count << " points (" << land << " on land), all polygons " << linearTime << "ms, grid " << gridTime << "ms, " << diff << " differences.";
+
+	std::ostringstream ss;
+	ss << "HIT TEST " << linearTime << "MS -> " << gridTime << "MS, " << diff << " DIFFERENCES";
+	return ss.str();
 }
 
 /**
@@ -575,6 +784,7 @@ void Globe::setZoom(size_t zoom)
 	_zoom = Clamp(zoom, (size_t)0u, _zoomRadius.size() - 1);
 	_zoomTexture = (2 - (int)floor(_zoom / 2.0)) * (_texture->getTotalFrames() / 3);
 	_radius = _zoomRadius[_zoom];
+	_shadowMap.clear();
 	_game->getSavedGame()->setGlobeZoom(_zoom);
 	if (_isMouseScrolling)
 	{
@@ -862,36 +1072,54 @@ void Globe::cache(std::list<Polygon*> *polygons, std::list<Polygon*> *cache)
 	}
 	cache->clear();
 
-	// Pre-calculate values to cache
-	for (auto* polygon : *polygons)
+	// Pre-calculate values to cache, every polygon is independent so they are spread over the worker threads
+	std::vector<Polygon*> source(polygons->begin(), polygons->end());
+	std::vector<Polygon*> result(source.size(), nullptr);
+	const int parts = std::min(ThreadPool::getDefault().getThreadCount() * 4, (int)source.size() / 64 + 1);
+	ThreadPool::getDefault().parallelFor(parts, [&](int part, int worker)
 	{
-		// Is quad on the back face?
-		double closest = 0.0;
-		double z;
-		double furthest = 0.0;
-		for (int j = 0; j < polygon->getPoints(); ++j)
+		const size_t end = source.size() * (part + 1) / parts;
+		for (size_t i = source.size() * part / parts; i < end; ++i)
 		{
-			z = cos(_cenLat) * cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j) - _cenLon) + sin(_cenLat) * sin(polygon->getLatitude(j));
-			if (z > closest)
-				closest = z;
-			else if (z < furthest)
-				furthest = z;
-		}
-		if (-furthest > closest)
-			continue;
+			const Polygon* polygon = source[i];
 
-		Polygon* p = new Polygon(*polygon);
+			// Is quad on the back face?
+			double closest = 0.0;
+			double z;
+			double furthest = 0.0;
+			for (int j = 0; j < polygon->getPoints(); ++j)
+			{
+				z = cos(_cenLat) * cos(polygon->getLatitude(j)) * cos(polygon->getLongitude(j) - _cenLon) + sin(_cenLat) * sin(polygon->getLatitude(j));
+				if (z > closest)
+					closest = z;
+				else if (z < furthest)
+					furthest = z;
+			}
+			if (-furthest > closest)
+				continue;
 
-		// Convert coordinates
-		for (int j = 0; j < p->getPoints(); ++j)
-		{
-			Sint16 x, y;
-			polarToCart(p->getLongitude(j), p->getLatitude(j), &x, &y);
-			p->setX(j, x);
-			p->setY(j, y);
+			Polygon* p = new Polygon(*polygon);
+
+			// Convert coordinates
+			for (int j = 0; j < p->getPoints(); ++j)
+			{
+				Sint16 x, y;
+				polarToCart(p->getLongitude(j), p->getLatitude(j), &x, &y);
+				p->setX(j, x);
+				p->setY(j, y);
+			}
+
+			result[i] = p;
 		}
+	});
 
-		cache->push_back(p);
+	// Keep original order, it decides which polygon is drawn on top
+	for (auto* p : result)
+	{
+		if (p)
+		{
+			cache->push_back(p);
+		}
 	}
 }
 
@@ -1057,28 +1285,57 @@ Cord Globe::getSunDirection(double lon, double lat) const
 }
 
 
+/**
+ * Shades the globe according to the time of day.
+ * Shadow of each pixel is kept in a map that is only recalculated
+ * when the sun moved enough on screen to change it.
+ */
 void Globe::drawShadow()
 {
-	if (Options::globeSurfaceCache)
-	{
-		ShaderMove<Cord> earth = ShaderMove<Cord>(SurfaceRaw<Cord>(_earthData[_zoom], getWidth(), getHeight()));
-		ShaderRepeat<Sint16> noise = ShaderRepeat<Sint16>(SurfaceRaw<Sint16>(static_data.random_noise, static_data.random_surf_size, static_data.random_surf_size));
-
-		earth.setMove(_cenX-getWidth()/2, _cenY-getHeight()/2);
+	const int width = getWidth();
+	const int height = getHeight();
+	const Cord sun = getSunDirection(_cenLon, _cenLat);
 
-		lock();
-		ShaderDraw<CreateShadow>(ShaderSurface(this), earth, ShaderScalar(getSunDirection(_cenLon, _cenLat)), noise);
-		unlock();
-	}
-	else
+	// game time moves the sun very slowly compared to rotating the globe, less than half a pixel is not visible
+	Cord diff = sun;
+	diff -= _shadowSun;
+	if (_shadowMap.size() != (size_t)(width * height) || diff.norm() * _zoomRadius[_zoom] > 0.5)
 	{
+		_shadowMap.resize(width * height);
+		_shadowSun = sun;
+
 		ShaderRepeat<Sint16> noise = ShaderRepeat<Sint16>(SurfaceRaw<Sint16>(static_data.random_noise, static_data.random_surf_size, static_data.random_surf_size));
+		if (Options::globeSurfaceCache)
+		{
+			ShaderMove<Cord> earth = ShaderMove<Cord>(SurfaceRaw<Cord>(_earthData[_zoom], width, height));
+			earth.setMove(_cenX-width/2, _cenY-height/2);
 
-		lock();
-		ShaderDraw<CreateShadowWithoutCache>(ShaderSurface(this), helper::Offset(_cenX, _cenY), ShaderScalar(getSunDirection(_cenLon, _cenLat)), noise, ShaderScalar(_zoomRadius[_zoom]));
-		unlock();
+			drawBands(height, [&](int yBegin, int yEnd)
+			{
+				auto shadow = ShaderSurface(SurfaceRaw<Uint8>(_shadowMap, width, height));
+				shadow.setDomain(GraphSubset(std::make_pair(0, width), std::make_pair(yBegin, yEnd)));
+				ShaderDraw<CreateShadowMap>(shadow, earth, ShaderScalar(sun), noise);
+			});
+		}
+		else
+		{
+			drawBands(height, [&](int yBegin, int yEnd)
+			{
+				auto shadow = ShaderSurface(SurfaceRaw<Uint8>(_shadowMap, width, height));
+				shadow.setDomain(GraphSubset(std::make_pair(0, width), std::make_pair(yBegin, yEnd)));
+				ShaderDraw<CreateShadowMapWithoutCache>(shadow, helper::Offset(_cenX, _cenY), ShaderScalar(sun), noise, ShaderScalar(_zoomRadius[_zoom]));
+			});
+		}
 	}
 
+	lock();
+	drawBands(height, [&](int yBegin, int yEnd)
+	{
+		auto dest = ShaderSurface(this);
+		dest.setDomain(GraphSubset(std::make_pair(0, width), std::make_pair(yBegin, yEnd)));
+		ShaderDraw<CreateShadow>(dest, ShaderSurface(SurfaceRaw<Uint8>(_shadowMap, width, height)));
+	});
+	unlock();
 }
 
 
@@ -2103,6 +2360,7 @@ void Globe::setupRadii(int width, int height)
 
 	_radius = _zoomRadius[_zoom];
 	_radiusStep = (_zoomRadius[DOGFIGHT_ZOOM] - _zoomRadius[0]) / 10.0;
+	_shadowMap.clear();
 
 	if (Options::globeSurfaceCache)
 	{
@@ -2112,11 +2370,14 @@ void Globe::setupRadii(int width, int height)
 		for (size_t r = 0; r<_zoomRadius.size(); ++r)
 		{
 			_earthData[r].resize(width * height);
-			for (int j=0; j<height; ++j)
-				for (int i=0; i<width; ++i)
-				{
-					_earthData[r][width*j + i] = static_data.circle_norm(width/2, height/2, _zoomRadius[r], i+.5, j+.5);
-				}
+			drawBands(height, [&](int yBegin, int yEnd)
+			{
+				for (int j=yBegin; j<yEnd; ++j)
+					for (int i=0; i<width; ++i)
+					{
+						_earthData[r][width*j + i] = static_data.circle_norm(width/2, height/2, _zoomRadius[r], i+.5, j+.5);
+					}
+			});
 		}
 	}
 	else
@@ -19,6 +19,7 @@
  */
 #include <vector>
 #include <list>
+#include <string>
 #include "../Engine/InteractiveSurface.h"
 #include "../Engine/FastLineClip.h"
 #include "Cord.h"
@@ -50,6 +51,8 @@ private:
 	static const int MAX_DRAW_RADAR_CIRCLE_RADIUS = 10000;
 	static const size_t DOGFIGHT_ZOOM = 3;
 	static const int CITY_MARKER = 8;
+	static const int POLYGON_GRID_LON = 180;
+	static const int POLYGON_GRID_LAT = 90;
 	static const double ROTATE_LONGITUDE;
 	static const double ROTATE_LATITUDE;
 
@@ -65,12 +68,18 @@ private:
 	int _blink;
 	Timer *_blinkTimer, *_rotTimer;
 	std::list<Polygon*> _cacheLand;
+	///globe polygons sorted into longitude/latitude cells
+	std::vector<std::vector<Polygon*> > _polygonGrid;
 	FastLineClip *_clipper;
 	double _radius, _radiusStep;
 	///normal of each pixel in earth globe per zoom level
 	std::vector<std::vector<Cord> > _earthData;
 	///list of dimension of earth on screen per zoom level
 	std::vector<double> _zoomRadius;
+	///shadow of each pixel of globe, reused until sun moves
+	std::vector<Uint8> _shadowMap;
+	///sun direction used for current shadow map
+	Cord _shadowSun;
 
 	bool _isMouseScrolling, _isMouseScrolled;
 	int _xBeforeMouseScrolling, _yBeforeMouseScrolling;
@@ -85,6 +94,10 @@ private:
 	bool pointBack(double lon, double lat) const;
 	/// Get polygon pointer
 	Polygon* getPolygonFromLonLat(double lon, double lat) const;
+	/// Sorts all polygons into the polygon grid.
+	void cachePolygonGrid();
+	/// Gets the polygon grid cell of a point.
+	size_t getPolygonGridCell(double lon, double lat) const;
 	/// Checks if a target is near a point.
 	bool targetNear(Target* target, int x, int y) const;
 	/// Caches a set of polygons.
@@ -163,6 +176,8 @@ public:
 	std::vector<Target*> getTargets(int x, int y, bool craft, Craft *currentCraft) const;
 	/// Caches visible globe polygons.
 	void cachePolygons();
+	/// Measures polygon hit testing with and without the polygon grid.
+	std::string benchmarkHitTest() const;
 	/// Sets the palette of the globe.
 	void setPalette(const SDL_Color *colors, int firstcolor = 0, int ncolors = 256) override;
 	/// Handles the timers.
@@ -98,6 +98,11 @@ SaveGameState::SaveGameState(OptionsOrigin origin, SaveType type, SDL_Color *pal
 	default:
 		break;
 	}
+	if (isBackground())
+	{
+		// nothing to wait for, the game goes on while the save is written
+		_firstRun = 10;
+	}
 
 	buildUi(palette);
 }
@@ -185,13 +190,27 @@ void SaveGameState::think()
 		// Save the game
 		try
 		{
-			std::string backup = _filename + ".bak";
-			_game->getSavedGame()->save(backup, _game->getMod());
-			std::string fullPath = Options::getMasterUserFolder() + _filename;
-			std::string bakPath = Options::getMasterUserFolder() + backup;
-			if (!CrossPlatform::moveFile(bakPath, fullPath))
+			// earlier background save needs to finish first, it could be writing the same file
+			std::string backgroundError = SavedGame::finishBackgroundSave();
+			if (!backgroundError.empty())
+			{
+				error(backgroundError);
+			}
+
+			if (isBackground())
+			{
+				_game->getSavedGame()->saveInBackground(_filename, _game->getMod());
+			}
+			else
 			{
-				throw Exception("Save backed up in " + backup);
+				std::string backup = _filename + ".bak";
+				_game->getSavedGame()->save(backup, _game->getMod());
+				std::string fullPath = Options::getMasterUserFolder() + _filename;
+				std::string bakPath = Options::getMasterUserFolder() + backup;
+				if (!CrossPlatform::moveFile(bakPath, fullPath))
+				{
+					throw Exception("Save backed up in " + backup);
+				}
 			}
 
 			if (_type == SAVE_IRONMAN_END)
@@ -221,6 +240,16 @@ void SaveGameState::think()
 	}
 }
 
+/**
+ * Checks if the save is written on a background thread,
+ * only done for autosaves.
+ * @return True for background save.
+ */
+bool SaveGameState::isBackground() const
+{
+	return Options::oxceBackgroundAutosave && (_type == SAVE_AUTO_GEOSCAPE || _type == SAVE_AUTO_BATTLESCAPE);
+}
+
 /**
  * Pops up a window with an error message.
  * @param msg Error message.
@@ -39,6 +39,8 @@ private:
 	Text *_txtStatus;
 	std::string _filename;
 	SaveType _type;
+	/// Is the save written on a background thread?
+	bool isBackground() const;
 public:
 	/// Creates the Save Game state.
 	SaveGameState(OptionsOrigin origin, const std::string &filename, SDL_Color *palette);
@@ -22,19 +22,23 @@
 #include <SDL_endian.h>
 #include "../Engine/Exception.h"
 #include "../Engine/SurfaceSet.h"
+#include "../Engine/ShaderDraw.h"
+#include "../Engine/ShaderMove.h"
 #include "../Engine/FileMap.h"
 #include "../Engine/Logger.h"
+#include "../Engine/Options.h"
 
 namespace OpenXcom
 {
 
 MapData *MapDataSet::_blankTile = 0;
 MapData *MapDataSet::_scorchedTile = 0;
+size_t MapDataSet::_shadedFramesTotalSize = 0;
 
 /**
  * MapDataSet construction.
  */
-MapDataSet::MapDataSet(const std::string &name) : _name(name), _surfaceSet(0), _loaded(false)
+MapDataSet::MapDataSet(const std::string &name) : _name(name), _surfaceSet(0), _shadedFramesSize(0), _shadedFramesLimitReached(false), _loaded(false)
 {
 }
 
@@ -98,6 +102,56 @@ SurfaceSet *MapDataSet::getSurfaceset() const
 	return _surfaceSet;
 }
 
+/**
+ * Gets a frame of the surfaces with shade already applied, so it can be drawn
+ * without shading each pixel. All shade levels of a frame are prepared on
+ * first use, as long as all terrains together stay under the memory limit.
+ * @param i Frame index.
+ * @param shade Shade level.
+ * @return Shaded frame, or empty one when not available.
+ */
+SurfaceRaw<const Uint8> MapDataSet::getShadedFrame(int i, int shade)
+{
+	if (shade < 0 || shade >= ShadedLevels || Options::oxceShadedTerrainMemory <= 0 || !_surfaceSet)
+	{
+		return {};
+	}
+	const Surface *frame = _surfaceSet->getFrame(i);
+	if (!frame)
+	{
+		return {};
+	}
+
+	const size_t levelSize = (size_t)frame->getPitch() * frame->getHeight();
+	if ((size_t)i >= _shadedFrames.size())
+	{
+		_shadedFrames.resize(i + 1);
+	}
+	std::vector<Uint8> &shaded = _shadedFrames[i];
+	if (shaded.empty())
+	{
+		const size_t size = levelSize * ShadedLevels;
+		if (_shadedFramesTotalSize + size > (size_t)Options::oxceShadedTerrainMemory * 1024 * 1024)
+		{
+			if (!_shadedFramesLimitReached)
+			{
+				Log(LOG_WARNING) << "Shaded terrain sprites reached limit of " << Options::oxceShadedTerrainMemory << " MB (" << _shadedFramesTotalSize / 1024 << " KB used, terrain " << _name << " uses " << _shadedFramesSize / 1024 << " KB), remaining sprites of " << _name << " are shaded while drawing.";
+				_shadedFramesLimitReached = true;
+			}
+			return {};
+		}
+		shaded.resize(size, 0);
+		for (int level = 0; level < ShadedLevels; ++level)
+		{
+			SurfaceRaw<Uint8> dest(shaded.data() + level * levelSize, frame->getWidth(), frame->getHeight(), frame->getPitch());
+			ShaderDraw<helper::StandardShade>(ShaderSurface(dest), ShaderSurface(SurfaceRaw<const Uint8>(frame)), ShaderScalar(level));
+		}
+		_shadedFramesSize += size;
+		_shadedFramesTotalSize += size;
+	}
+	return SurfaceRaw<const Uint8>(shaded.data() + shade * levelSize, frame->getWidth(), frame->getHeight(), frame->getPitch());
+}
+
 /**
  * Loads terrain data in XCom format (MCD & PCK files).
  * @sa http://www.ufopaedia.org/index.php?title=MCD
@@ -260,6 +314,14 @@ void MapDataSet::unloadData()
 		}
 		_objects.clear();
 		delete _surfaceSet;
+		if (_shadedFramesSize)
+		{
+			Log(LOG_INFO) << "Terrain " << _name << " used " << _shadedFramesSize / 1024 << " KB for shaded sprites.";
+			_shadedFramesTotalSize -= _shadedFramesSize;
+			_shadedFramesSize = 0;
+		}
+		_shadedFrames.clear();
+		_shadedFramesLimitReached = false;
 		_loaded = false;
 	}
 }
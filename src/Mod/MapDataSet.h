@@ -27,6 +27,7 @@ namespace OpenXcom
 
 class MapData;
 class SurfaceSet;
+template<typename Pixel> class SurfaceRaw;
 
 /**
  * Represents a Terrain Map Datafile.
@@ -40,10 +41,17 @@ private:
 	std::string _name;
 	std::vector<MapData*> _objects;
 	SurfaceSet *_surfaceSet;
+	std::vector<std::vector<Uint8>> _shadedFrames;
+	size_t _shadedFramesSize;
+	bool _shadedFramesLimitReached;
 	bool _loaded;
 	static MapData *_blankTile;
 	static MapData *_scorchedTile;
+	static size_t _shadedFramesTotalSize;
 public:
+	/// Number of shade levels kept for each frame.
+	static constexpr int ShadedLevels = 16;
+
 	MapDataSet(const std::string &name);
 	~MapDataSet();
 	/// Loads voxeldata from a DAT file.
@@ -58,6 +66,8 @@ public:
 	MapData *getObject(size_t i);
 	/// Gets the surfaces in this dataset.
 	SurfaceSet *getSurfaceset() const;
+	/// Gets a frame of the surfaces with shade already applied.
+	SurfaceRaw<const Uint8> getShadedFrame(int i, int shade);
 	/// Loads the objects from an MCD file.
 	void loadData(MCDPatch *patch, bool validate = true);
 	///	Unloads to free memory.
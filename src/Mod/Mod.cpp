@@ -23,6 +23,10 @@
 #include <sstream>
 #include <climits>
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <exception>
+#include <future>
 #include "../version.h"
 #include "../Engine/CrossPlatform.h"
 #include "../Engine/FileMap.h"
@@ -44,6 +48,7 @@
 #include "../Engine/Logger.h"
 #include "../Engine/ScriptBind.h"
 #include "../Engine/Collections.h"
+#include "../Engine/ThreadPool.h"
 #include "SoundDefinition.h"
 #include "ExtraSprites.h"
 #include "CustomPalettes.h"
@@ -2149,6 +2154,124 @@ static void throwModOnErrorHelper(const std::string& modId, const std::string& e
 	throw Exception(errorStream.str());
 }
 
+/**
+ * Ruleset file parsed ahead of loading its rules.
+ */
+struct ModRulesetFile
+{
+	/// File of the ruleset
+	FileMap::FileRecord file;
+	/// Index of the mod the file belongs to
+	size_t mod = 0;
+	/// Parsed content, empty if parsing failed
+	std::unique_ptr<YAML::YamlRootNodeReader> reader;
+	/// Error of parsing, thrown when the file is loaded
+	std::exception_ptr error;
+};
+
+/**
+ * Ruleset files of all mods in loading order. Files are parsed on worker threads
+ * a window of files ahead of loading them: when loading reaches a parsed window,
+ * the next one starts parsing in the background, so at most two windows of parsed files are kept at once.
+ * With a single thread each file is parsed just before it is loaded.
+ * Parsing errors are kept and thrown when the file is loaded, so loading
+ * stops at the same file and with the same message in both cases.
+ */
+class ModRulesetQueue
+{
+	std::vector<std::vector<ModRulesetFile>> _mods;
+	std::vector<ModRulesetFile*> _files;
+	size_t _next, _parsed, _window, _pendingEnd;
+	Uint32 _parseTime;
+	/// Window of files from _parsed to _pendingEnd being parsed in the background, declared last so it is waited for first.
+	std::future<Uint32> _pending;
+
+	/// Parses one file.
+	static void parse(ModRulesetFile &f)
+	{
+		try
+		{
+			f.reader = std::make_unique<YAML::YamlRootNodeReader>(f.file.getRawData(), f.file.fullpath);
+		}
+		catch (...)
+		{
+			f.error = std::current_exception();
+		}
+	}
+
+	/// Parses files from begin to end, returns time it took in milliseconds.
+	Uint32 parseWindow(size_t begin, size_t end)
+	{
+		const Uint32 start = SDL_GetTicks();
+		if (end - begin == 1)
+		{
+			parse(*_files[begin]);
+		}
+		else
+		{
+			ThreadPool::getDefault().parallelFor((int)(end - begin), [&](int i, int)
+			{
+				parse(*_files[begin + i]);
+			});
+		}
+		return SDL_GetTicks() - start;
+	}
+public:
+	/// Sorts ruleset files of each mod in loading order.
+	ModRulesetQueue(const FileMap::RSOrder& mods) : _mods(mods.size()), _next(0), _parsed(0), _pendingEnd(0), _parseTime(0)
+	{
+		for (size_t i = 0; mods.size() > i; ++i)
+		{
+			std::vector<FileMap::FileRecord> sortedRulesetFiles = mods[i].second;
+			std::sort(sortedRulesetFiles.begin(), sortedRulesetFiles.end(),
+				[](const FileMap::FileRecord& a, const FileMap::FileRecord& b)
+				{ return a.fullpath > b.fullpath; });
+
+			_mods[i].resize(sortedRulesetFiles.size());
+			for (size_t j = 0; sortedRulesetFiles.size() > j; ++j)
+			{
+				_mods[i][j].file = sortedRulesetFiles[j];
+				_mods[i][j].mod = i;
+				_files.push_back(&_mods[i][j]);
+			}
+		}
+		const int threads = ThreadPool::getDefault().getThreadCount();
+		_window = threads > 1 ? 4 * threads : 1;
+	}
+
+	/// Gets time spent parsing, in milliseconds, most of it overlapped with loading when parsing in the background.
+	Uint32 getParseTime() const { return _parseTime; }
+
+	/// Gets number of ruleset files of a mod.
+	size_t getFileCount(size_t mod) const { return _mods[mod].size(); }
+
+	/// Gets the next file to load, it needs to belong to the given mod.
+	ModRulesetFile &next(size_t mod)
+	{
+		if (_next == _parsed)
+		{
+			if (_pending.valid())
+			{
+				_parseTime += _pending.get();
+				_parsed = _pendingEnd;
+			}
+			else
+			{
+				_parsed = std::min(_files.size(), _next + _window);
+				_parseTime += parseWindow(_next, _parsed);
+			}
+			if (_window > 1 && _parsed < _files.size())
+			{
+				const size_t begin = _parsed;
+				_pendingEnd = std::min(_files.size(), begin + _window);
+				_pending = std::async(std::launch::async, [this, begin, end = _pendingEnd]{ return parseWindow(begin, end); });
+			}
+		}
+		assert(_files[_next]->mod == mod && "ruleset files need to be loaded in mod order");
+		return *_files[_next++];
+	}
+};
+
 /**
  * Loads a list of mods specified in the options.
  * List of <modId, rulesetFiles> pairs is fetched from the FileMap / VFS
@@ -2160,6 +2283,14 @@ void Mod::loadAll()
 	const auto& mods = FileMap::getRulesets();
 
 	Log(LOG_INFO) << "Loading begins...";
+	// time spent in each loading phase
+	Uint32 phaseStart = SDL_GetTicks();
+	auto phaseDone = [&](const char *phase)
+	{
+		Uint32 phaseEnd = SDL_GetTicks();
+		Log(LOG_INFO) << phase << " took " << phaseEnd - phaseStart << " ms.";
+		phaseStart = phaseEnd;
+	};
 	if (Options::oxceModValidationLevel < LOG_ERROR)
 	{
 		Log(LOG_ERROR) << "Validation of mod data disabled, game can crash when run";
@@ -2211,6 +2342,8 @@ void Mod::loadAll()
 		}
 	}
 
+	phaseDone("Pre-loading rulesets");
+
 	Log(LOG_INFO) << "Loading vanilla resources...";
 	// vanilla resources load
 	_modCurrent = &_modData.at(0);
@@ -2225,7 +2358,11 @@ void Mod::loadAll()
 	_soundOffsetBattle = _sounds["BATTLE.CAT"]->getMaxSharedSounds();
 	_soundOffsetGeo = _sounds["GEO.CAT"]->getMaxSharedSounds();
 
+	phaseDone("Loading vanilla resources");
+
 	Log(LOG_INFO) << "Loading rulesets...";
+	// parsing files is independent, only loading rules depends on the order
+	ModRulesetQueue rulesets(mods);
 	// load rest rulesets
 	for (size_t i = 0; mods.size() > i; ++i)
 	{
@@ -2233,7 +2370,7 @@ void Mod::loadAll()
 		{
 			_modCurrent = &_modData.at(i);
 			_scriptGlobal->setMod((int)_modCurrent->offset);
-			loadMod(mods[i].second, parser);
+			loadMod(rulesets, i, parser);
 		}
 		catch (Exception &e)
 		{
@@ -2242,6 +2379,8 @@ void Mod::loadAll()
 		}
 	}
 	Log(LOG_INFO) << "Loading rulesets done.";
+	Log(LOG_INFO) << "Parsing rulesets took " << rulesets.getParseTime() << " ms.";
+	phaseDone("Loading rulesets");
 
 	//back master
 	_modCurrent = &_modData.at(0);
@@ -2453,30 +2592,39 @@ void Mod::loadAll()
 	}
 
 	Log(LOG_INFO) << "Loading ended.";
+	phaseDone("After load");
 
 	sortLists();
+	phaseDone("Sorting lists");
 	modResources();
+	phaseDone("Mod resources");
 }
 
 /**
  * Loads a list of rulesets from YAML files for the mod at the specified index. The first
  * mod loaded should be the master at index 0, then 1, and so on.
- * @param rulesetFiles List of rulesets to load.
+ * @param rulesets Ruleset files of all mods, in loading order.
+ * @param mod Index of the mod.
  * @param parsers Object with all available parsers.
  */
-void Mod::loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, ModScript &parsers)
+void Mod::loadMod(ModRulesetQueue &rulesets, size_t mod, ModScript &parsers)
 {
-	std::vector<FileMap::FileRecord> sortedRulesetFiles = rulesetFiles;
-	std::sort(sortedRulesetFiles.begin(), sortedRulesetFiles.end(),
-		[](const FileMap::FileRecord& a, const FileMap::FileRecord& b)
-		{ return a.fullpath > b.fullpath; });
-	for (const auto& filerec : sortedRulesetFiles)
+	for (size_t i = 0; i < rulesets.getFileCount(mod); ++i)
 	{
+		ModRulesetFile& rulesetFile = rulesets.next(mod);
+		const FileMap::FileRecord& filerec = rulesetFile.file;
 		Log(LOG_VERBOSE) << "- " << filerec.fullpath;
 		try
 		{
 			_scriptGlobal->fileLoad(filerec.fullpath);
-			loadFile(filerec, parsers);
+			if (rulesetFile.error)
+			{
+				Log(LOG_FATAL) << "Error loading file '" << filerec.fullpath << "'";
+				std::rethrow_exception(rulesetFile.error);
+			}
+			loadFile(*rulesetFile.reader, parsers);
+			// rules keep no references to the parsed file
+			rulesetFile.reader.reset();
 		}
 		catch (Exception &e)
 		{
@@ -2702,14 +2850,13 @@ void Mod::loadConstants(const YAML::YamlNodeReader &reader)
 }
 
 /**
- * Loads a ruleset's contents from a YAML file.
+ * Loads a ruleset's contents from a parsed YAML file.
  * Rules that match pre-existing rules overwrite them.
- * @param filename YAML filename.
+ * @param r Parsed YAML file.
  * @param parsers Object with all available parsers.
  */
-void Mod::loadFile(const FileMap::FileRecord &filerec, ModScript &parsers)
+void Mod::loadFile(const YAML::YamlRootNodeReader &r, ModScript &parsers)
 {
-	YAML::YamlRootNodeReader r = filerec.getYAML();
 	YAML::YamlNodeReader reader = r.useIndex();
 
 	auto loadDocInfoHelper = [&](const char* nodeName)
@@ -5731,6 +5878,7 @@ void Mod::loadBattlescapeResources()
 		createTransparencyLUT(_palettes[pals[i]]);
 		delete tempSurface;
 	}
+	saveTransparencyLUTCache();
 
 	std::string spks[] = { "TAC01.SCR",
 		"DETBORD.PCK",
@@ -6090,7 +6238,14 @@ void Mod::loadExtraResources()
 			createTransparencyLUT(_palettes["PAL_BATTLESCAPE_2"]);
 			createTransparencyLUT(_palettes["PAL_BATTLESCAPE_3"]);
 		}
+		saveTransparencyLUTCache();
 	}
+	if (!_transparencyLUTs.empty())
+	{
+		Log(LOG_INFO) << "Transparency LUTs took " << _transparencyLUTTime << " ms, " << _transparencyLUTReused << " of " << _transparencyLUTs.size() << " taken from the cache.";
+	}
+	// all LUTs are created by now, drop the copies read from the cache file
+	_transparencyLUTCache.clear();
 
 	TextButton::soundPress = getSound("GEO.CAT", Mod::BUTTON_PRESS);
 	Window::soundPopup[0] = getSound("GEO.CAT", Mod::WINDOW_POPUP[0]);
@@ -6330,6 +6485,136 @@ Music* Mod::loadMusic(MusicFormat fmt, RuleMusic* rule, CatFile* adlibcat, CatFi
 	return music;
 }
 
+/// File in the user folder with transparency LUTs of the last run.
+static const std::string TransparencyLUTCacheFile = "transparency.cache";
+/// Start of the cache file, change it when the format changes.
+static const std::string TransparencyLUTCacheMagic = "OXCELUT1";
+
+/**
+ * Calculates the key of a transparency LUT, a hash of the game version,
+ * the tints and the palette, so the key changes with anything the LUT depends on.
+ * @param transparencies Tints of all opacity levels.
+ * @param palColors Colors of the palette.
+ * @return FNV-1a hash.
+ */
+static Uint64 transparencyLUTKeyHelper(const std::vector<std::array<SDL_Color, Mod::TransparenciesOpacityLevels>>& transparencies, const SDL_Color* palColors)
+{
+	Uint64 hash = 14695981039346656037ULL;
+	auto add = [&](Uint8 byte)
+	{
+		hash = (hash ^ byte) * 1099511628211ULL;
+	};
+	for (const char* c = OPENXCOM_VERSION_LONG OPENXCOM_VERSION_GIT; *c; ++c)
+	{
+		add(*c);
+	}
+	for (const auto& tintLevels : transparencies)
+	{
+		for (const SDL_Color& tint : tintLevels)
+		{
+			add(tint.r);
+			add(tint.g);
+			add(tint.b);
+			add(tint.unused);
+		}
+	}
+	// separates tints from the palette, a different number of tints always changes the key
+	add(0xFF);
+	add((Uint8)transparencies.size());
+	for (int i = 0; i < Mod::TransparenciesPaletteColors; ++i)
+	{
+		add(palColors[i].r);
+		add(palColors[i].g);
+		add(palColors[i].b);
+	}
+	return hash;
+}
+
+/**
+ * Loads transparency LUTs saved by the last run.
+ * A missing or broken cache is just empty.
+ * @return LUTs by key.
+ */
+static std::map<Uint64, std::vector<Uint8> > loadTransparencyLUTCacheHelper()
+{
+	std::map<Uint64, std::vector<Uint8> > cache;
+	std::string filepath = Options::getUserFolder() + TransparencyLUTCacheFile;
+	if (!CrossPlatform::fileExists(filepath))
+	{
+		return cache;
+	}
+	try
+	{
+		RawData data = CrossPlatform::readFileRaw(filepath);
+		const Uint8* p = (const Uint8*)data.data();
+		const Uint8* end = p + data.size();
+		auto read = [&](size_t bytes)
+		{
+			Uint64 v = 0;
+			if ((size_t)(end - p) < bytes)
+			{
+				throw Exception("Broken " + filepath);
+			}
+			for (size_t i = 0; i < bytes; ++i)
+			{
+				v |= (Uint64)*p++ << (8 * i);
+			}
+			return v;
+		};
+		if (data.size() < TransparencyLUTCacheMagic.size() || memcmp(p, TransparencyLUTCacheMagic.data(), TransparencyLUTCacheMagic.size()) != 0)
+		{
+			return cache;
+		}
+		p += TransparencyLUTCacheMagic.size();
+		while (p != end)
+		{
+			Uint64 key = read(8);
+			size_t size = (size_t)read(4);
+			if ((size_t)(end - p) < size)
+			{
+				throw Exception("Broken " + filepath);
+			}
+			cache[key].assign(p, p + size);
+			p += size;
+		}
+	}
+	catch (Exception &e)
+	{
+		Log(LOG_WARNING) << e.what();
+		cache.clear();
+	}
+	return cache;
+}
+
+/**
+ * Saves transparency LUTs created in this run, failing to save them
+ * only makes the next start slower.
+ * @param keys Keys of the LUTs.
+ * @param luts The LUTs.
+ */
+static void saveTransparencyLUTCacheHelper(const std::vector<Uint64>& keys, const std::vector<std::vector<Uint8> >& luts)
+{
+	std::vector<unsigned char> data(TransparencyLUTCacheMagic.begin(), TransparencyLUTCacheMagic.end());
+	auto write = [&](Uint64 v, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			data.push_back((v >> (8 * i)) & 0xFF);
+		}
+	};
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		write(keys[i], 8);
+		write(luts[i].size(), 4);
+		data.insert(data.end(), luts[i].begin(), luts[i].end());
+	}
+	std::string filepath = Options::getUserFolder() + TransparencyLUTCacheFile;
+	if (!CrossPlatform::writeFile(filepath, data))
+	{
+		Log(LOG_WARNING) << "Failed to save " << filepath;
+	}
+}
+
 /**
  * Preamble:
  * this is the most horrible function i've ever written, and it makes me sad.
@@ -6341,7 +6626,27 @@ Music* Mod::loadMusic(MusicFormat fmt, RuleMusic* rule, CatFile* adlibcat, CatFi
  */
 void Mod::createTransparencyLUT(Palette *pal)
 {
+	const Uint32 start = SDL_GetTicks();
 	const SDL_Color* palColors = pal->getColors(0);
+
+	// same tints and palette as in the last run, reuse its result
+	const Uint64 key = transparencyLUTKeyHelper(_transparencies, palColors);
+	if (!_transparencyLUTCacheLoaded)
+	{
+		_transparencyLUTCache = loadTransparencyLUTCacheHelper();
+		_transparencyLUTCacheLoaded = true;
+	}
+	const size_t expectedSize = _transparencies.size() * TransparenciesOpacityLevels * TransparenciesPaletteColors;
+	auto cached = _transparencyLUTCache.find(key);
+	if (cached != _transparencyLUTCache.end() && cached->second.size() == expectedSize)
+	{
+		_transparencyLUTKeys.push_back(key);
+		_transparencyLUTs.push_back(cached->second);
+		++_transparencyLUTReused;
+		_transparencyLUTTime += SDL_GetTicks() - start;
+		return;
+	}
+
 	std::vector<Uint8> lookUpTable;
 	// start with the color sets
 	lookUpTable.reserve(_transparencies.size() * TransparenciesPaletteColors * TransparenciesOpacityLevels);
@@ -6382,7 +6687,23 @@ void Mod::createTransparencyLUT(Palette *pal)
 			}
 		}
 	}
+	_transparencyLUTKeys.push_back(key);
 	_transparencyLUTs.push_back(std::move(lookUpTable));
+	_transparencyLUTCacheChanged = true;
+	_transparencyLUTTime += SDL_GetTicks() - start;
+}
+
+/**
+ * Saves the transparency LUTs for the next run, if any of them
+ * had to be created instead of taken from the cache.
+ */
+void Mod::saveTransparencyLUTCache()
+{
+	if (_transparencyLUTCacheChanged)
+	{
+		saveTransparencyLUTCacheHelper(_transparencyLUTKeys, _transparencyLUTs);
+		_transparencyLUTCacheChanged = false;
+	}
 }
 
 StatAdjustment *Mod::getStatAdjustment(int difficulty)
@@ -104,6 +104,7 @@ class ModScript;
 class ModScriptGlobal;
 class ScriptParserBase;
 class ScriptGlobal;
+class ModRulesetQueue;
 struct StatAdjustment;
 
 enum GameDifficulty : int;
@@ -165,6 +166,16 @@ private:
 	std::map<std::string, Music*> _musics;
 	std::vector<Uint16> _voxelData;
 	std::vector<std::vector<Uint8> > _transparencyLUTs;
+	/// Keys of created transparency LUTs, hashes of everything they are made from.
+	std::vector<Uint64> _transparencyLUTKeys;
+	/// Transparency LUTs saved by the last run, by key.
+	std::map<Uint64, std::vector<Uint8> > _transparencyLUTCache;
+	bool _transparencyLUTCacheLoaded = false;
+	bool _transparencyLUTCacheChanged = false;
+	/// Time spent getting transparency LUTs, in milliseconds.
+	Uint32 _transparencyLUTTime = 0;
+	/// Number of transparency LUTs taken from the cache.
+	size_t _transparencyLUTReused = 0;
 
 	std::map<std::string, RuleCountry*> _countries, _extraGlobeLabels;
 	std::map<std::string, RuleRegion*> _regions;
@@ -332,8 +343,8 @@ private:
 	/// Loads a ruleset from a YAML file that have basic resources configuration.
 	void loadResourceConfigFile(const FileMap::FileRecord &filerec);
 	void loadConstants(const YAML::YamlNodeReader& reader);
-	/// Loads a ruleset from a YAML file.
-	void loadFile(const FileMap::FileRecord &filerec, ModScript &parsers);
+	/// Loads a ruleset from a parsed YAML file.
+	void loadFile(const YAML::YamlRootNodeReader &r, ModScript &parsers);
 
 	template<typename T>
 	struct RuleFactory
@@ -365,8 +376,10 @@ private:
 	Music* loadMusic(MusicFormat fmt, RuleMusic* rule, CatFile* adlibcat, CatFile* aintrocat, GMCatFile* gmcat) const;
 	/// Creates a transparency lookup table for a given palette.
 	void createTransparencyLUT(Palette *pal);
+	/// Saves created transparency LUTs for the next run.
+	void saveTransparencyLUTCache();
 	/// Loads a specified mod content.
-	void loadMod(const std::vector<FileMap::FileRecord> &rulesetFiles, ModScript &parsers);
+	void loadMod(ModRulesetQueue &rulesets, size_t mod, ModScript &parsers);
 	/// Loads resources from vanilla.
 	void loadVanillaResources();
 	/// Loads resources from extra rulesets.
@@ -56,6 +56,8 @@
 namespace OpenXcom
 {
 
+Uint32 BattleUnit::_visibilityVersion = 0;
+
 /**
  * Initializes a BattleUnit from a Soldier
  * @param soldier Pointer to the Soldier.
@@ -2324,9 +2326,20 @@ void BattleUnit::clearVisibleUnits()
  */
 bool BattleUnit::addToVisibleTiles(Tile *tile)
 {
+	const auto* save = tile->getSavedGame();
+	const size_t index = save->getTileIndex(tile->getPosition());
+	if (_visibleTilesLookup.size() != (size_t)save->getMapSizeXYZ())
+	{
+		_visibleTilesLookup.assign(save->getMapSizeXYZ(), false);
+		for (auto* t : _visibleTiles)
+		{
+			_visibleTilesLookup[save->getTileIndex(t->getPosition())] = true;
+		}
+	}
 	//Only add once, otherwise we're going to mess up the visibility value and make trouble for the AI (if sneaky).
-	if (_visibleTilesLookup.insert(tile).second)
+	if (!_visibleTilesLookup[index])
 	{
+		_visibleTilesLookup[index] = true;
 		tile->setVisible(1);
 		_visibleTiles.push_back(tile);
 		return true;
@@ -2334,6 +2347,17 @@ bool BattleUnit::addToVisibleTiles(Tile *tile)
 	return false;
 }
 
+/**
+ * Has this unit marked this tile as within its view?
+ * @param tile Tile to check.
+ * @return True if tile is in list of visible tiles.
+ */
+bool BattleUnit::hasVisibleTile(Tile *tile) const
+{
+	const size_t index = tile->getSavedGame()->getTileIndex(tile->getPosition());
+	return index < _visibleTilesLookup.size() && _visibleTilesLookup[index];
+}
+
 /**
  * Get the pointer to the vector of visible tiles.
  * @return pointer to vector.
@@ -2351,8 +2375,8 @@ void BattleUnit::clearVisibleTiles()
 	for (auto* tile : _visibleTiles)
 	{
 		tile->setVisible(-1);
+		_visibleTilesLookup[tile->getSavedGame()->getTileIndex(tile->getPosition())] = false;
 	}
-	_visibleTilesLookup.clear();
 	_visibleTiles.clear();
 }
 
@@ -2701,6 +2725,7 @@ void BattleUnit::prepareNewTurn(bool fullProcess)
 	if (_faction != _originalFaction)
 	{
 		_faction = _originalFaction;
+		++_visibilityVersion;
 		if (_faction == FACTION_PLAYER && _currentAIState)
 		{
 			delete _currentAIState;
@@ -3193,7 +3218,21 @@ AIModule *BattleUnit::getAIModule() const
  */
 void BattleUnit::setVisible(bool flag)
 {
-	_visible = flag;
+	if (_visible != flag)
+	{
+		_visible = flag;
+		++_visibilityVersion;
+	}
+}
+
+/**
+ * Gets a counter that changes every time any unit becomes visible or hidden,
+ * or changes faction, so results depending on what the player sees can be reused.
+ * @return Version of unit visibility.
+ */
+Uint32 BattleUnit::getVisibilityVersion()
+{
+	return _visibilityVersion;
 }
 
 
@@ -4544,6 +4583,7 @@ const std::string& BattleUnit::getType() const
 void BattleUnit::convertToFaction(UnitFaction f)
 {
 	_faction = f;
+	++_visibilityVersion;
 }
 
 /**
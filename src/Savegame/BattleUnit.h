@@ -19,7 +19,6 @@
  */
 #include <vector>
 #include <string>
-#include <unordered_set>
 #include "../Battlescape/Position.h"
 #include "../Mod/Armor.h"
 #include "../Mod/RuleItem.h"
@@ -91,7 +90,7 @@ private:
 	int _walkPhase, _fallPhase;
 	std::vector<BattleUnit *> _visibleUnits, _unitsSpottedThisTurn;
 	std::vector<Tile *> _visibleTiles;
-	std::unordered_set<Tile *> _visibleTilesLookup;
+	std::vector<bool> _visibleTilesLookup;
 	int _tu, _energy, _health, _morale, _stunlevel, _mana;
 	bool _kneeled, _floating, _dontReselect;
 	bool _haveNoFloorBelow = false;
@@ -102,6 +101,8 @@ private:
 	BattleItem* _specWeapon[SPEC_WEAPON_MAX];
 	AIModule *_currentAIState;
 	bool _visible;
+	/// Changes with visibility or faction of any unit.
+	static Uint32 _visibilityVersion;
 	UnitStats _exp, _expTmp;
 	int _motionPoints;
 	int _scannedTurn;
@@ -363,10 +364,7 @@ public:
 	/// Add unit to visible tiles.
 	bool addToVisibleTiles(Tile *tile);
 	/// Has this unit marked this tile as within its view?
-	bool hasVisibleTile(Tile *tile) const
-	{
-		return _visibleTilesLookup.find(tile) != _visibleTilesLookup.end(); //find?
-	}
+	bool hasVisibleTile(Tile *tile) const;
 	/// Get the list of visible tiles.
 	const std::vector<Tile*> *getVisibleTiles();
 	/// Clear visible tiles.
@@ -417,6 +415,8 @@ public:
 	void setVisible(bool flag);
 	/// Get whether this unit is visible
 	bool getVisible() const;
+	/// Gets counter of visibility and faction changes of all units.
+	static Uint32 getVisibilityVersion();
 
 	/// Check if unit can fall down.
 	void updateTileFloorState(SavedBattleGame *saveBattleGame);
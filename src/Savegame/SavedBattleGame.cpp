@@ -1469,6 +1469,12 @@ const RuleCraftDeployment& SavedBattleGame::getCustomDeployment(const RuleCraft*
  */
 void SavedBattleGame::endTurn()
 {
+	// units have moved, kept reachable tiles need to be recalculated
+	if (_pathfinding)
+	{
+		_pathfinding->invalidateReachable();
+	}
+
 	// reset turret direction for all hostile and neutral units (as it may have been changed during reaction fire)
 	for (auto* bu : _units)
 	{
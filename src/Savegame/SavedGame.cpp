@@ -19,10 +19,18 @@
 #include "SavedGame.h"
 #include <sstream>
 #include <set>
+#include <map>
 #include <iomanip>
 #include <algorithm>
 #include <functional>
 #include <ctime>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <string_view>
+#include <cstring>
+#include <cerrno>
+#include <exception>
 #include "../Engine/Yaml.h"
 #include "../version.h"
 #include "../Engine/Logger.h"
@@ -67,6 +75,9 @@
 #include "SoldierDiary.h"
 #include "../Mod/AlienRace.h"
 #include "RankCount.h"
+#define MINIZ_NO_STDIO
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#include "../../libs/miniz/miniz.h"
 
 namespace OpenXcom
 {
@@ -78,6 +89,341 @@ const std::string SavedGame::AUTOSAVE_GEOSCAPE = "_autogeo_.asav",
 namespace
 {
 
+/// Save being written on a background thread.
+std::thread backgroundSave;
+/// Error of the last background save.
+std::string backgroundSaveError;
+
+/// Start of the line that separates the header from compressed game data, followed by size of the uncompressed data.
+const std::string CompressedMarker = "--- # deflate ";
+/// Largest accepted size of uncompressed game data.
+const unsigned long long MaxUncompressedSize = 1ULL << 30;
+
+/**
+ * Writes output of the compressor to the save file.
+ */
+mz_bool writeCompressed(const void *buf, int len, void *user)
+{
+	auto &write = *(FuncRef<bool(const void *data, size_t size)>*)user;
+	return write(buf, len) ? MZ_TRUE : MZ_FALSE;
+}
+
+/**
+ * Writes the YAML documents of a save to a file.
+ * The header always stays readable, the game data after it can be compressed.
+ * Game data is emitted as one string first, its size is stored before the compressed data.
+ * Compressed output goes to the file block by block as the compressor produces it.
+ * @param headerWriter Writer of the header.
+ * @param writer Writer of the game data.
+ * @param filepath Full path of the file.
+ * @param compress Compress the game data.
+ */
+void writeSave(YAML::YamlRootNodeWriter &headerWriter, YAML::YamlRootNodeWriter &writer, const std::string &filepath, bool compress)
+{
+	// concatenate header + separator + body
+	// per yaml standard, "bare documents" in a yaml "stream" can be separated by either a "document end" or "directives end" marker line
+	YAML::YamlString headerString = headerWriter.emit();
+	YAML::YamlString bodyString = writer.emit();
+
+	bool written = CrossPlatform::writeFile(filepath, compress,
+		[&](FuncRef<bool(const void *data, size_t size)> write)
+		{
+			if (!write(headerString.yaml.data(), headerString.yaml.size()))
+			{
+				return false;
+			}
+			if (compress)
+			{
+				// the marker keeps the size of the game data, so loading can unpack it in one go
+				const std::string marker = CompressedMarker + std::to_string(bodyString.yaml.size()) + "\n";
+				const int flags = tdefl_create_comp_flags_from_zip_params(MZ_BEST_SPEED, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+				return write(marker.data(), marker.size())
+					&& tdefl_compress_mem_to_output(bodyString.yaml.data(), bodyString.yaml.size(), writeCompressed, &write, flags);
+			}
+			else
+			{
+				const std::string directivesEndMarker = "---\n";
+				return write(directivesEndMarker.data(), directivesEndMarker.size())
+					&& write(bodyString.yaml.data(), bodyString.yaml.size());
+			}
+		}
+	);
+
+	if (!written)
+	{
+		throw Exception("Failed to save " + filepath);
+	}
+}
+
+/**
+ * Reads a save file, game data saved compressed is unpacked
+ * so the result is always plain YAML documents.
+ * @param filepath Full path of the file.
+ * @return Content of the save.
+ */
+RawData readSave(const std::string &filepath)
+{
+	RawData data = CrossPlatform::readFileRaw(filepath);
+	const std::string_view file((const char*)data.data(), data.size());
+
+	const size_t headerEnd = file.find("\n---");
+	if (headerEnd == std::string_view::npos || file.compare(headerEnd + 1, CompressedMarker.size(), CompressedMarker) != 0)
+	{
+		return data;
+	}
+	const size_t markerEnd = file.find('\n', headerEnd + 1);
+	if (markerEnd == std::string_view::npos)
+	{
+		throw Exception("Compressed game data missing in " + filepath);
+	}
+	const std::string sizeText(file.substr(headerEnd + 1 + CompressedMarker.size(), markerEnd - headerEnd - 1 - CompressedMarker.size()));
+	char *sizeEnd = nullptr;
+	errno = 0;
+	const unsigned long long bodySize = strtoull(sizeText.c_str(), &sizeEnd, 10);
+	if (sizeText.empty() || *sizeEnd != 0 || errno != 0 || sizeText[0] == '-')
+	{
+		throw Exception("Compressed game data missing in " + filepath);
+	}
+	// deflate can't pack better than about 1:1032, anything above that or the hard limit is a damaged file
+	const size_t packedSize = file.size() - markerEnd - 1;
+	if (bodySize > MaxUncompressedSize || bodySize > (unsigned long long)packedSize * 1032 + 1024)
+	{
+		throw Exception("Compressed game data damaged in " + filepath);
+	}
+
+	const std::string separator = "---\n";
+	const size_t headerSize = headerEnd + 1;
+	const size_t size = headerSize + separator.size() + bodySize;
+	char *buffer = (char*)SDL_malloc(size + 1);
+	if (buffer == NULL)
+	{
+		throw Exception("Not enough memory to load " + filepath);
+	}
+	RawData result(buffer, size, SDL_free);
+	memcpy(buffer, file.data(), headerSize);
+	memcpy(buffer + headerSize, separator.data(), separator.size());
+	mz_ulong unpackedSize = bodySize;
+	const unsigned char *packed = (const unsigned char*)file.data() + markerEnd + 1;
+	if (mz_uncompress((unsigned char*)buffer + headerSize + separator.size(), &unpackedSize, packed, packedSize) != MZ_OK || unpackedSize != bodySize)
+	{
+		throw Exception("Compressed game data damaged in " + filepath);
+	}
+	buffer[size] = 0;
+	return result;
+}
+
+/// File in the user folder that keeps the headers of saves shown in the save list.
+const std::string SaveIndexFile = "saves.idx";
+/// Saves written by this game since the last listing, their index entries are never trusted.
+/// Foreground saves are written to a .bak file that is renamed afterwards.
+std::set<std::string> writtenSaves;
+/// Format of the save index, older indexes are rebuilt.
+const int SaveIndexVersion = 2;
+
+/**
+ * Parts of a save header shown in the save list,
+ * together with the size and date of the file they were read from.
+ */
+struct SaveHeader
+{
+	uint64_t modified = 0;
+	uint64_t size = 0;
+	bool hasName = false;
+	std::string name;
+	GameTime time = GameTime(6, 1, 1, 1999, 12, 0, 0);
+	bool battle = false;
+	int turn = 0;
+	std::string mission;
+	bool ironman = false;
+	std::vector<std::string> mods;
+
+	/**
+	 * Loads the shown parts from a save header or an index entry.
+	 * @param reader YAML node.
+	 */
+	void load(const YAML::YamlNodeReader &reader)
+	{
+		hasName = reader.tryRead("name", name);
+		time.load(reader["time"]);
+		battle = (bool)reader["turn"];
+		if (battle)
+		{
+			turn = reader["turn"].readVal<int>();
+			mission = reader["mission"].readVal<std::string>();
+		}
+		ironman = reader["ironman"].readVal(false);
+		reader.tryRead("mods", mods);
+	}
+
+	/**
+	 * Saves the shown parts to an index entry.
+	 * @param writer YAML node.
+	 */
+	void save(YAML::YamlNodeWriter writer) const
+	{
+		if (hasName)
+			writer.write("name", name);
+		time.save(writer["time"]);
+		if (battle)
+		{
+			writer.write("turn", turn);
+			writer.write("mission", mission);
+		}
+		if (ironman)
+			writer.write("ironman", ironman);
+		writer.write("mods", mods);
+	}
+};
+
+/**
+ * Loads the save index, a missing or broken index is just empty.
+ * @return Headers by file name.
+ */
+std::map<std::string, SaveHeader> loadSaveIndex()
+{
+	std::map<std::string, SaveHeader> index;
+	std::string filepath = Options::getMasterUserFolder() + SaveIndexFile;
+	if (!CrossPlatform::fileExists(filepath))
+	{
+		return index;
+	}
+	try
+	{
+		YAML::YamlRootNodeReader reader(filepath, false, false);
+		if (reader["version"].readVal(0) != SaveIndexVersion)
+		{
+			return index;
+		}
+		for (const auto& entry : reader["saves"].children())
+		{
+			SaveHeader header;
+			header.modified = entry["modified"].readVal<uint64_t>();
+			header.size = entry["size"].readVal<uint64_t>();
+			header.load(entry);
+			index[entry["file"].readVal<std::string>()] = header;
+		}
+	}
+	catch (Exception &e)
+	{
+		Log(LOG_WARNING) << filepath << ": " << e.what();
+		index.clear();
+	}
+	catch (YAML::Exception &e)
+	{
+		Log(LOG_WARNING) << filepath << ": " << e.what();
+		index.clear();
+	}
+	return index;
+}
+
+/**
+ * Saves the save index, failing to save it only makes the next listing slower.
+ * @param index Headers by file name.
+ */
+void saveSaveIndex(const std::map<std::string, SaveHeader> &index)
+{
+	std::string yaml;
+	try
+	{
+		YAML::YamlRootNodeWriter writer;
+		writer.setAsMap();
+		writer.write("version", SaveIndexVersion);
+		auto savesWriter = writer["saves"];
+		savesWriter.setAsSeq();
+		for (const auto& pair : index)
+		{
+			auto entryWriter = savesWriter.write();
+			entryWriter.setAsMap();
+			entryWriter.write("file", pair.first);
+			entryWriter.write("modified", pair.second.modified);
+			entryWriter.write("size", pair.second.size);
+			pair.second.save(entryWriter);
+		}
+		yaml = writer.emit().yaml;
+	}
+	catch (YAML::Exception &e)
+	{
+		Log(LOG_WARNING) << e.what();
+		return;
+	}
+	std::string filepath = Options::getMasterUserFolder() + SaveIndexFile;
+	if (!CrossPlatform::writeFile(filepath, yaml + "\n"))
+	{
+		Log(LOG_WARNING) << "Failed to save " << filepath;
+	}
+}
+
+/**
+ * Gets the info of a specific save file.
+ * @param file Save filename.
+ * @param timestamp Modified date of the save file, from the folder listing.
+ * @param header Header of the save.
+ * @param lang Loaded language.
+ */
+SaveInfo getSaveInfo(const std::string &file, time_t timestamp, const SaveHeader &header, Language *lang)
+{
+	SaveInfo save;
+
+	save.fileName = file;
+
+	if (save.fileName == SavedGame::QUICKSAVE)
+	{
+		save.displayName = lang->getString("STR_QUICK_SAVE_SLOT");
+		save.reserved = true;
+	}
+	else if (save.fileName == SavedGame::AUTOSAVE_GEOSCAPE)
+	{
+		save.displayName = lang->getString("STR_AUTO_SAVE_GEOSCAPE_SLOT");
+		save.reserved = true;
+	}
+	else if (save.fileName.find(SavedGame::AUTOSAVE_GEOSCAPE) != std::string::npos)
+	{
+		save.displayName = lang->getString("STR_AUTO_SAVE_GEOSCAPE_SLOT_WITH_NUMBER").arg(header.time.getDayString(lang));
+		save.reserved = true;
+	}
+	else if (save.fileName == SavedGame::AUTOSAVE_BATTLESCAPE)
+	{
+		save.displayName = lang->getString("STR_AUTO_SAVE_BATTLESCAPE_SLOT");
+		save.reserved = true;
+	}
+	else if (save.fileName.find(SavedGame::AUTOSAVE_BATTLESCAPE) != std::string::npos)
+	{
+		save.displayName = lang->getString("STR_AUTO_SAVE_BATTLESCAPE_SLOT_WITH_NUMBER").arg(header.turn);
+		save.reserved = true;
+	}
+	else
+	{
+		save.displayName = header.hasName ? header.name : CrossPlatform::noExt(file);
+		save.reserved = false;
+	}
+
+	save.timestamp = timestamp;
+	std::pair<std::string, std::string> str = CrossPlatform::timeToString(save.timestamp);
+	save.isoDate = str.first;
+	save.isoTime = str.second;
+	save.mods = header.mods;
+
+	std::ostringstream details;
+	if (header.battle)
+	{
+		details << lang->getString("STR_BATTLESCAPE") << ": " << lang->getString(header.mission) << ", ";
+		details << lang->getString("STR_TURN").arg(header.turn);
+	}
+	else
+	{
+		details << lang->getString("STR_GEOSCAPE") << ": ";
+		details << header.time.getDayString(lang) << " " << lang->getString(header.time.getMonthString()) << " " << header.time.getYear() << ", ";
+		details << header.time.getHour() << ":" << std::setfill('0') << std::setw(2) << header.time.getMinute();
+	}
+	if (header.ironman)
+	{
+		details << " (" << lang->getString("STR_IRONMAN") << ")";
+	}
+	save.details = details.str();
+
+	return save;
+}
+
 bool researchLess(const RuleResearch *a, const RuleResearch *b)
 {
 	return std::less<const RuleResearch *>{}(a, b);
@@ -250,6 +596,7 @@ static bool _isCurrentGameType(const SaveInfo &saveInfo, const std::string &curM
  */
 std::vector<SaveInfo> SavedGame::getList(Language *lang, bool autoquick)
 {
+	finishBackgroundSave();
 	std::vector<SaveInfo> info;
 	std::string curMaster = Options::getActiveMaster();
 	auto saves = CrossPlatform::getFolderContents(Options::getMasterUserFolder(), "sav");
@@ -259,12 +606,46 @@ std::vector<SaveInfo> SavedGame::getList(Language *lang, bool autoquick)
 		auto asaves = CrossPlatform::getFolderContents(Options::getMasterUserFolder(), "asav");
 		saves.insert(saves.begin(), asaves.begin(), asaves.end());
 	}
+
+	// only headers of new or changed files are read, the rest comes from the index
+	std::map<std::string, SaveHeader> index = loadSaveIndex();
+	std::set<std::string> listed;
+	bool indexChanged = false;
 	for (const auto& tuple : saves)
 	{
 		const auto& filename = std::get<0>(tuple);
+		listed.insert(filename);
 		try
 		{
-			SaveInfo saveInfo = getSaveInfo(filename, lang);
+			std::string fullname = Options::getMasterUserFolder() + filename;
+			time_t timestamp = std::get<2>(tuple);
+			uint64_t size = 0, modified = 0;
+			const bool stamped = CrossPlatform::getFileStamp(fullname, size, modified);
+			auto cached = index.find(filename);
+			SaveHeader header;
+			if (!stamped || cached == index.end() || cached->second.modified != modified || cached->second.size != size
+				|| writtenSaves.count(filename) || writtenSaves.count(filename + ".bak"))
+			{
+				YAML::YamlRootNodeReader reader(fullname, true);
+				header.modified = modified;
+				header.size = size;
+				header.load(reader);
+				if (stamped)
+				{
+					index.insert_or_assign(filename, header);
+				}
+				else
+				{
+					// without a stamp the entry could never be checked, don't keep it
+					index.erase(filename);
+				}
+				indexChanged = true;
+			}
+			else
+			{
+				header = cached->second;
+			}
+			SaveInfo saveInfo = getSaveInfo(filename, timestamp, header, lang);
 			if (!_isCurrentGameType(saveInfo, curMaster))
 			{
 				continue;
@@ -283,85 +664,32 @@ std::vector<SaveInfo> SavedGame::getList(Language *lang, bool autoquick)
 		}
 	}
 
-	return info;
-}
-
-/**
- * Gets the info of a specific save file.
- * @param file Save filename.
- * @param lang Loaded language.
- */
-SaveInfo SavedGame::getSaveInfo(const std::string &file, Language *lang)
-{
-	std::string fullname = Options::getMasterUserFolder() + file;
-	YAML::YamlRootNodeReader reader(fullname, true);
-	SaveInfo save;
-
-	save.fileName = file;
-
-	if (save.fileName == QUICKSAVE)
-	{
-		save.displayName = lang->getString("STR_QUICK_SAVE_SLOT");
-		save.reserved = true;
-	}
-	else if (save.fileName == AUTOSAVE_GEOSCAPE)
-	{
-		save.displayName = lang->getString("STR_AUTO_SAVE_GEOSCAPE_SLOT");
-		save.reserved = true;
-	}
-	else if (save.fileName.find(AUTOSAVE_GEOSCAPE) != std::string::npos)
-	{
-		GameTime time = GameTime(6, 1, 1, 1999, 12, 0, 0);
-		if (reader["time"])
-			time.load(reader["time"]);
-		save.displayName = lang->getString("STR_AUTO_SAVE_GEOSCAPE_SLOT_WITH_NUMBER").arg(time.getDayString(lang));
-		save.reserved = true;
-	}
-	else if (save.fileName == AUTOSAVE_BATTLESCAPE)
-	{
-		save.displayName = lang->getString("STR_AUTO_SAVE_BATTLESCAPE_SLOT");
-		save.reserved = true;
-	}
-	else if (save.fileName.find(AUTOSAVE_BATTLESCAPE) != std::string::npos)
-	{
-		int turn = reader["turn"].readVal(0);
-		save.displayName = lang->getString("STR_AUTO_SAVE_BATTLESCAPE_SLOT_WITH_NUMBER").arg(turn);
-		save.reserved = true;
-	}
-	else
+	// saves not listed now (autosaves when autoquick is off) still need to be checked next time
+	for (const auto& filename : listed)
 	{
-		if (!reader.tryRead("name", save.displayName))
-			save.displayName = CrossPlatform::noExt(file);
-		save.reserved = false;
+		writtenSaves.erase(filename);
+		writtenSaves.erase(filename + ".bak");
 	}
 
-	save.timestamp = CrossPlatform::getDateModified(fullname);
-	std::pair<std::string, std::string> str = CrossPlatform::timeToString(save.timestamp);
-	save.isoDate = str.first;
-	save.isoTime = str.second;
-	reader.tryRead("mods", save.mods);
-
-	std::ostringstream details;
-	if (reader["turn"])
+	// forget deleted files, autosaves are kept when they were not listed
+	for (auto i = index.begin(); i != index.end();)
 	{
-		details << lang->getString("STR_BATTLESCAPE") << ": " << lang->getString(reader["mission"].readVal<std::string>()) << ", ";
-		details << lang->getString("STR_TURN").arg(reader["turn"].readVal<int>());
-	}
-	else
-	{
-		GameTime time = GameTime(6, 1, 1, 1999, 12, 0, 0);
-		time.load(reader["time"]);
-		details << lang->getString("STR_GEOSCAPE") << ": ";
-		details << time.getDayString(lang) << " " << lang->getString(time.getMonthString()) << " " << time.getYear() << ", ";
-		details << time.getHour() << ":" << std::setfill('0') << std::setw(2) << time.getMinute();
+		if (!listed.count(i->first) && (autoquick || CrossPlatform::compareExt(i->first, "sav")))
+		{
+			i = index.erase(i);
+			indexChanged = true;
+		}
+		else
+		{
+			++i;
+		}
 	}
-	if (reader["ironman"].readVal(false))
+	if (indexChanged)
 	{
-		details << " (" << lang->getString("STR_IRONMAN") << ")";
+		saveSaveIndex(index);
 	}
-	save.details = details.str();
 
-	return save;
+	return info;
 }
 
 /**
@@ -373,8 +701,9 @@ SaveInfo SavedGame::getSaveInfo(const std::string &file, Language *lang)
  */
 void SavedGame::load(const std::string &filename, Mod *mod, Language *lang)
 {
+	finishBackgroundSave();
 	std::string filepath = Options::getMasterUserFolder() + filename;
-	YAML::YamlRootNodeReader documents(filepath, false, false);
+	YAML::YamlRootNodeReader documents(readSave(filepath), filepath, false);
 
 	// Get brief save info
 	const auto& header = documents[0];
@@ -727,6 +1056,93 @@ void saveVector(YAML::YamlNodeWriter& writer, const std::vector<T*>& vector, con
 void SavedGame::save(const std::string &filename, Mod *mod) const
 {
 	YAML::YamlRootNodeWriter headerWriter;
+	YAML::YamlRootNodeWriter writer(1000000); //1MB starting buffer
+	saveDocuments(headerWriter, writer, mod);
+	writtenSaves.insert(filename);
+	writeSave(headerWriter, writer, Options::getMasterUserFolder() + filename, Options::oxceCompressedSaves);
+}
+
+/**
+ * Saves a saved game's contents to a YAML file on a background thread.
+ * The contents are copied before returning, so the game can go on
+ * while they are written. The file is written under a temporary
+ * name first, so the old save stays intact if anything fails.
+ * @param filename YAML filename.
+ */
+void SavedGame::saveInBackground(const std::string &filename, Mod *mod) const
+{
+	// the previous save could still be writing the same file
+	if (backgroundSave.joinable())
+	{
+		backgroundSave.join();
+	}
+
+	auto headerWriter = std::make_shared<YAML::YamlRootNodeWriter>();
+	auto writer = std::make_shared<YAML::YamlRootNodeWriter>(1000000); //1MB starting buffer
+	saveDocuments(*headerWriter, *writer, mod);
+	writtenSaves.insert(filename);
+
+	const std::string filepath = Options::getMasterUserFolder() + filename;
+	const bool compress = Options::oxceCompressedSaves;
+	backgroundSave = std::thread([headerWriter, writer, filepath, filename, compress]()
+	{
+		std::string error;
+		try
+		{
+			writeSave(*headerWriter, *writer, filepath + ".bak", compress);
+			if (!CrossPlatform::moveFile(filepath + ".bak", filepath))
+			{
+				throw Exception("Save backed up in " + filename + ".bak");
+			}
+		}
+		catch (Exception &e)
+		{
+			error = e.what();
+		}
+		catch (YAML::Exception &e)
+		{
+			error = e.what();
+		}
+		catch (std::exception &e)
+		{
+			// anything escaping the thread would end the game
+			error = e.what();
+		}
+		catch (...)
+		{
+			error = "Unknown error";
+		}
+		if (!error.empty())
+		{
+			Log(LOG_ERROR) << "Failed to save " << filepath << ": " << error;
+			backgroundSaveError = error;
+		}
+	});
+}
+
+/**
+ * Waits until the background save is written.
+ * Needs to be called before reading saves or quitting the game.
+ * @return Error of the background save, empty if it succeeded.
+ */
+std::string SavedGame::finishBackgroundSave()
+{
+	if (backgroundSave.joinable())
+	{
+		backgroundSave.join();
+	}
+	return std::exchange(backgroundSaveError, std::string());
+}
+
+/**
+ * Fills the YAML documents of the save, the brief
+ * header shown in the saves list and the full game data.
+ * @param headerWriter Writer of the header.
+ * @param writer Writer of the game data.
+ * @param mod Pointer to mod.
+ */
+void SavedGame::saveDocuments(YAML::YamlRootNodeWriter &headerWriter, YAML::YamlRootNodeWriter &writer, Mod *mod) const
+{
 	headerWriter.setAsMap();
 	// Saves the brief game info used in the saves list
 
@@ -756,7 +1172,6 @@ void SavedGame::save(const std::string &filename, Mod *mod) const
 		headerWriter.write("ironman", _ironman);
 
 	// Saves the full game data to the save
-	YAML::YamlRootNodeWriter writer(1000000); //1MB starting buffer
 	writer.setAsMap();
 	writer.write("difficulty", _difficulty);
 	writer.write("end", _end);
@@ -872,23 +1287,6 @@ void SavedGame::save(const std::string &filename, Mod *mod) const
 	if (_battleGame)
 		_battleGame->save(writer["battleGame"]);
 	_scriptValues.save(writer.toBase(), mod->getScriptGlobal());
-
-	// concatenate header + separator + body
-	// per yaml standard, "bare documents" in a yaml "stream" can be separated by either a "document end" or "directives end" marker line
-	YAML::YamlString headerString = headerWriter.emit();
-	std::string directivesEndMarker = "---\n";
-	YAML::YamlString bodyString = writer.emit();
-	std::string finalString;
-	finalString.reserve(headerString.yaml.size() + directivesEndMarker.size() + bodyString.yaml.size());
-	finalString += headerString.yaml;
-	finalString	+= directivesEndMarker;
-	finalString += bodyString.yaml;
-
-	std::string filepath = Options::getMasterUserFolder() + filename;
-	if (!CrossPlatform::writeFile(filepath, finalString))
-	{
-		throw Exception("Failed to save " + filepath);
-	}
 }
 
 /**
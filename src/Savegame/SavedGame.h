@@ -176,7 +176,8 @@ private:
 	bool _alienContainmentChecked;
 	ScriptValues<SavedGame> _scriptValues;
 
-	static SaveInfo getSaveInfo(const std::string &file, Language *lang);
+	/// Fills the YAML documents of the save.
+	void saveDocuments(YAML::YamlRootNodeWriter &headerWriter, YAML::YamlRootNodeWriter &writer, Mod *mod) const;
 public:
 	static const std::string AUTOSAVE_GEOSCAPE, AUTOSAVE_BATTLESCAPE, QUICKSAVE;
 	/// Creates a new saved game.
@@ -193,6 +194,10 @@ public:
 	void loadUfopediaRuleStatus(const YAML::YamlNodeReader& reader);
 	/// Saves a saved game to YAML.
 	void save(const std::string &filename, Mod *mod) const;
+	/// Saves a saved game to YAML on a background thread.
+	void saveInBackground(const std::string &filename, Mod *mod) const;
+	/// Waits until the background save is written.
+	static std::string finishBackgroundSave();
 	/// Gets the game name.
 	std::string getName() const;
 	/// Sets the game name.
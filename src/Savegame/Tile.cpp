@@ -30,6 +30,8 @@
 #include "../Mod/Armor.h"
 #include "SerializationHelper.h"
 #include "../Battlescape/BattlescapeGame.h"
+#include "../Battlescape/TileEngine.h"
+#include "../Battlescape/Pathfinding.h"
 #include "../fmath.h"
 #include "SavedBattleGame.h"
 
@@ -266,6 +268,8 @@ void Tile::setMapData(MapData *dat, int mapDataID, int mapDataSetID, TilePart pa
 		_cache.isLadderOnWest = _objects[O_WESTWALL] && _objects[O_WESTWALL]->isGravLift();
 	}
 	updateSprite(part);
+	updateVoxelTerrain();
+	updatePathfinding();
 }
 
 /**
@@ -395,6 +399,7 @@ int Tile::openDoor(TilePart part, BattleUnit *unit, BattleActionType reserve, bo
 			return 4;
 		_objectsCache[part].currentFrame = 1; // start opening door
 		updateSprite((TilePart)part);
+		updateVoxelTerrain();
 		return 1;
 	}
 	if (_objectsCache[part].isUfoDoor && _objectsCache[part].currentFrame != 7) // ufo door != part 7 - door is still opening
@@ -415,6 +420,8 @@ int Tile::closeUfoDoor()
 			_objectsCache[part].currentFrame = 0;
 			retval = 1;
 			updateSprite((TilePart)part);
+			updateVoxelTerrain();
+			updatePathfinding();
 		}
 	}
 
@@ -703,6 +710,10 @@ void Tile::animate()
 			{
 				continue;
 			}
+			if (_objectsCache[i].isUfoDoor && _objectsCache[i].currentFrame == 1) // ufo door starts to be passable
+			{
+				updatePathfinding();
+			}
 			newframe = _objectsCache[i].currentFrame + 1;
 			if (_objectsCache[i].isUfoDoor && _objects[i]->getSpecialType() == START_POINT && newframe == 3)
 			{
@@ -733,6 +744,57 @@ void Tile::updateSprite(TilePart part)
 	}
 }
 
+/**
+ * Get object sprite with shade already applied, if its terrain has it prepared.
+ * @param part Part of tile.
+ * @param shade Shade level.
+ * @return Shaded sprite or empty one.
+ */
+SurfaceRaw<const Uint8> Tile::getShadedSprite(TilePart part, int shade) const
+{
+	if (_objects[part])
+	{
+		return _objects[part]->getDataset()->getShadedFrame(_objects[part]->getSprite(_objectsCache[part].currentFrame), shade);
+	}
+	return {};
+}
+
+/**
+ * Notify tile engine that voxel shape of this tile changed.
+ */
+void Tile::updateVoxelTerrain()
+{
+	auto* tileEngine = _save->getTileEngine();
+	if (tileEngine)
+	{
+		tileEngine->voxelTerrainInvalidate(this);
+	}
+}
+
+/**
+ * Notify pathfinding that move costs around this tile changed.
+ */
+void Tile::updatePathfinding()
+{
+	auto* pathfinding = _save->getPathfinding();
+	if (pathfinding)
+	{
+		pathfinding->invalidateTerrain(_pos);
+	}
+}
+
+/**
+ * Notify pathfinding that units, fire or smoke on this tile changed.
+ */
+void Tile::updatePathfindingReachable()
+{
+	auto* pathfinding = _save->getPathfinding();
+	if (pathfinding)
+	{
+		pathfinding->invalidateReachable();
+	}
+}
+
 /**
  * Get unit from this tile or from tile below if unit poke out.
  * @param saveBattleGame
@@ -753,6 +815,19 @@ BattleUnit *Tile::getOverlappingUnit(const SavedBattleGame *saveBattleGame, Tile
 	return bu;
 }
 
+/**
+ * Set a unit on this tile.
+ * @param unit Unit or null.
+ */
+void Tile::setUnit(BattleUnit *unit)
+{
+	if (_unit != unit)
+	{
+		_unit = unit;
+		updatePathfindingReachable();
+	}
+}
+
 /**
  * Set the amount of turns this tile is on fire. 0 = no fire.
  * @param fire : amount of turns this tile is on fire.
@@ -761,6 +836,7 @@ void Tile::setFire(int fire)
 {
 	_fire = Clamp(fire, 0, 255);
 	_animationOffset = RNG::generate(0,3);
+	updatePathfindingReachable();
 }
 
 /**
@@ -790,6 +866,7 @@ void Tile::addSmoke(int smoke)
 		}
 		_animationOffset = RNG::generate(0,3);
 		addOverlap();
+		updatePathfindingReachable();
 	}
 }
 
@@ -801,6 +878,7 @@ void Tile::setSmoke(int smoke)
 {
 	_smoke = Clamp(smoke, 0, 255);
 	_animationOffset = RNG::generate(0,3);
+	updatePathfindingReachable();
 }
 
 
@@ -320,19 +320,22 @@ public:
 	void animate();
 	/// Update cached value of sprite.
 	void updateSprite(TilePart part);
+	/// Update cached voxel shape of terrain.
+	void updateVoxelTerrain();
+	/// Update cached move costs of terrain.
+	void updatePathfinding();
+	/// Update cached reachable tiles.
+	void updatePathfindingReachable();
 	/// Get object sprites.
 	SurfaceRaw<const Uint8> getSprite(TilePart part) const
 	{
 		return _currentSurface[part];
 	}
+	/// Get object sprites with shade already applied.
+	SurfaceRaw<const Uint8> getShadedSprite(TilePart part, int shade) const;
 
-	/**
-	 * Set a unit on this tile.
-	 */
-	void setUnit(BattleUnit *unit)
-	{
-		_unit = unit;
-	}
+	/// Set a unit on this tile.
+	void setUnit(BattleUnit *unit);
 
 	/**
 	 * Get the (alive) unit on this tile.